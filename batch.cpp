@@ -0,0 +1,346 @@
+#include "batch.h"
+#include "ingest.h"
+#include "json.h"
+#include "instrumentation.h"
+#include "task_pool.h"
+#include "parallel.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+using namespace std;
+
+namespace {
+// Same as the menu program: chargers within 25 m of each other are one site
+const double COLLAPSE_EPSILON_KM = 0.025;
+
+struct StateResult {
+    string state;
+    string error;
+    int stations = 0;
+    long long edges = 0;
+    long long buildNs = 0;
+    long long stateNs = 0;
+    vector<Placement> placements;
+};
+
+// A data file's stations, loaded once and split by state
+struct Dataset {
+    int stationCount = 0;
+    map<string, vector<Node>> byState;
+    long long loadNs = 0;
+};
+
+long long nanosecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+vector<string> splitList(const string& list) {
+    vector<string> items;
+    stringstream stream(list);
+    string item;
+    while (getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// Builds one state's graph and makes the job's placements in it, numbering the new stations
+// from firstId. Only touches its own state, so states can run at the same time.
+void runState(const BatchJob& job, const vector<Node>& nodes, int firstId, StateResult& result) {
+    auto start = chrono::steady_clock::now();
+    TraceScope trace("state", result.state);
+    GraphOptions options;
+    options.mode = job.mode;
+    options.k = job.k;
+    options.maxRadius = job.threshold;
+    PlacementSession session(result.state, nodes, options, job.threshold);
+    result.stations = session.currentGraph().size();
+    result.edges = session.currentGraph().edgeCount(session.searchThreshold());
+    result.buildNs = session.buildNs();
+    for (int i = 0; i < job.placements; i++) {
+        Placement placement = session.place(job.algorithm, firstId + i);
+        if (!placement.placed) {
+            result.error = "no two stations are connected";
+            break;
+        }
+        result.placements.push_back(placement);
+    }
+    result.stateNs = nanosecondsSince(start);
+}
+
+// Runs every state of the job, several at once when there is more than one, and returns the
+// number of workers used. States are started largest first, so the big ones that bound the
+// total time are never left until the end. They share the scheduler with the parallel stages
+// inside them, so a worker that finishes its state early helps with another state's searches.
+int runStates(const BatchJob& job, const Dataset& data, vector<StateResult>& results) {
+    vector<const vector<Node>*> stateNodes(results.size(), nullptr);
+    vector<int> order;
+    for (size_t s = 0; s < results.size(); s++) {
+        StateResult& result = results[s];
+        string abbreviation = stateAbbreviation(result.state);
+        if (abbreviation.empty()) {
+            result.error = "not a U.S. state";
+            continue;
+        }
+        result.state = abbreviation;
+        auto it = data.byState.find(abbreviation);
+        if (it == data.byState.end()) {
+            result.error = "no stations";
+            continue;
+        }
+        stateNodes[s] = &it->second;
+        order.push_back(static_cast<int>(s));
+    }
+    stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return stateNodes[a]->size() > stateNodes[b]->size();
+    });
+
+    // new stations are numbered after the data file's, like in the menu program, with a block
+    // of ids per listed state so the numbering does not depend on which state finishes first
+    auto firstId = [&](int s) { return data.stationCount + s * job.placements; };
+    int workers = min(workerCount(), static_cast<int>(order.size()));
+    if (workers <= 1) {
+        for (int s : order) {
+            runState(job, *stateNodes[s], firstId(s), results[s]);
+        }
+        return 1;
+    }
+    TaskGroup group(scheduler());
+    for (int s : order) {
+        group.run([&, s] { runState(job, *stateNodes[s], firstId(s), results[s]); });
+    }
+    group.wait();
+    return workers;
+}
+
+void writeStateResult(ostream& out, const StateResult& result) {
+    out << "{\"state\": " << jsonQuote(result.state);
+    if (!result.error.empty()) {
+        out << ", \"error\": " << jsonQuote(result.error);
+    }
+    out << ", \"stations\": " << result.stations << ", \"edges\": " << result.edges
+        << ", \"build_ns\": " << result.buildNs << ", \"state_ns\": " << result.stateNs << ", \"placements\": [";
+    for (size_t i = 0; i < result.placements.size(); i++) {
+        const Placement& placement = result.placements[i];
+        out << (i == 0 ? "" : ", ") << "{\"id\": " << placement.station.id
+            << ", \"latitude\": " << placement.station.latitude
+            << ", \"longitude\": " << placement.station.longitude
+            << ", \"source\": " << placement.sourceId << ", \"farthest\": " << placement.farthestId
+            << ", \"distance_km\": " << placement.distance << ", \"search_ns\": " << placement.searchNs
+            << ", \"rebuild_ns\": " << placement.rebuildNs << "}";
+    }
+    out << "]}";
+}
+
+// Parses "--key value" pairs into the defaults every job starts from
+bool parseArguments(const vector<string>& arguments, BatchJob& defaults, string& jobFile, string& output) {
+    for (size_t i = 0; i < arguments.size(); i++) {
+        const string& flag = arguments[i];
+        if (flag == "--batch") {
+            continue;
+        }
+        if (flag.compare(0, 2, "--") != 0 || i + 1 >= arguments.size()) {
+            cerr << "Expected --option value, got " << flag << endl;
+            return false;
+        }
+        const string& value = arguments[++i];
+        string error;
+        if (flag == "--job") {
+            jobFile = value;
+        } else if (flag == "--output") {
+            output = value;
+        } else if (!applyBatchOption(flag.substr(2), value, defaults, error)) {
+            cerr << error << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool readJobFile(const string& path, const BatchJob& defaults, vector<BatchJob>& jobs) {
+    ifstream file(path);
+    if (!file.is_open()) {
+        cerr << "Error: Could not open file " << path << endl;
+        return false;
+    }
+    string line;
+    int lineNumber = 0;
+    while (getline(file, line)) {
+        lineNumber++;
+        stringstream tokens(line);
+        string token;
+        BatchJob job = defaults;
+        bool any = false;
+        while (tokens >> token) {
+            if (token[0] == '#') {
+                break;
+            }
+            size_t equals = token.find('=');
+            string error = "expected key=value";
+            if (equals == string::npos ||
+                !applyBatchOption(token.substr(0, equals), token.substr(equals + 1), job, error)) {
+                cerr << path << ":" << lineNumber << ": " << error << endl;
+                return false;
+            }
+            any = true;
+        }
+        if (any) {
+            jobs.push_back(job);
+        }
+    }
+    return true;
+}
+}
+
+bool applyBatchOption(const string& key, const string& value, BatchJob& job, string& error) {
+    try {
+        if (key == "states") {
+            job.states = splitList(value);
+        } else if (key == "algorithm") {
+            if (!parsePlacementAlgorithm(value, job.algorithm)) {
+                error = "Unknown algorithm " + value + " (dijkstra, bellman_ford, radix, farthest_pair, "
+                        "incremental or parallel_bellman_ford)";
+                return false;
+            }
+        } else if (key == "placements") {
+            job.placements = stoi(value);
+        } else if (key == "threshold") {
+            job.threshold = stod(value);
+        } else if (key == "mode") {
+            if (value == "threshold") {
+                job.mode = GraphMode::Threshold;
+            } else if (value == "knn") {
+                job.mode = GraphMode::KNearest;
+            } else {
+                error = "Mode must be threshold or knn";
+                return false;
+            }
+        } else if (key == "k") {
+            job.k = stoi(value);
+        } else if (key == "data") {
+            job.dataPath = value;
+        } else {
+            error = "Unknown option " + key;
+            return false;
+        }
+    } catch (const logic_error&) {
+        error = "Invalid value for " + key + ": " + value;
+        return false;
+    }
+    if (job.placements < 0 || !(job.threshold > 0.0) || !isfinite(job.threshold) || job.k < 1) {
+        error = "placements must be at least 0, threshold a finite distance greater than 0 km and k at least 1";
+        return false;
+    }
+    return true;
+}
+
+int runBatch(const vector<string>& arguments) {
+    BatchJob defaults;
+    string jobFile;
+    string output;
+    if (!parseArguments(arguments, defaults, jobFile, output)) {
+        return 2;
+    }
+    vector<BatchJob> jobs;
+    if (jobFile.empty()) {
+        jobs.push_back(defaults);
+    } else if (!readJobFile(jobFile, defaults, jobs)) {
+        return 2;
+    }
+
+    map<string, Dataset> loaded;  // by data path, shared by the jobs using it
+    ostringstream out;
+    out.precision(10);
+    out << "{\"jobs\": [";
+    for (size_t j = 0; j < jobs.size(); j++) {
+        const BatchJob& job = jobs[j];
+        auto jobStart = chrono::steady_clock::now();
+        out << (j == 0 ? "\n" : ",\n") << "  {\"job\": " << j + 1 << ", \"algorithm\": \""
+            << placementAlgorithmName(job.algorithm) << "\", \"placements_requested\": " << job.placements
+            << ", \"threshold_km\": " << job.threshold << ", \"graph_mode\": \"" << graphModeName(job.mode)
+            << "\", \"k\": " << job.k << ", \"data\": " << jsonQuote(job.dataPath);
+
+        if (loaded.find(job.dataPath) == loaded.end()) {
+            auto start = chrono::steady_clock::now();
+            vector<Node> nodes;
+            if (!loadStations(job.dataPath, nodes)) {
+                out << ", \"error\": \"could not open data file\", \"states\": []}";
+                continue;
+            }
+            collapseColocatedStations(nodes, COLLAPSE_EPSILON_KM);
+            Dataset& data = loaded[job.dataPath];
+            data.stationCount = nodes.size();
+            for (const Node& node : nodes) {
+                data.byState[node.stateOrProvince].push_back(node);
+            }
+            data.loadNs = nanosecondsSince(start);
+        }
+        const Dataset& data = loaded[job.dataPath];
+        out << ", \"load_ns\": " << data.loadNs << ", \"states\": [";
+
+        vector<StateResult> results;
+        bool allStates = job.states.size() == 1 && stateAbbreviation(job.states[0]).empty() &&
+                         (job.states[0] == "all" || job.states[0] == "ALL");
+        if (allStates) {
+            // every state with stations, largest first
+            for (const auto& state : data.byState) {
+                results.push_back(StateResult());
+                results.back().state = state.first;
+            }
+            stable_sort(results.begin(), results.end(), [&](const StateResult& a, const StateResult& b) {
+                return data.byState.at(a.state).size() > data.byState.at(b.state).size();
+            });
+        } else {
+            for (const string& state : job.states) {
+                results.push_back(StateResult());
+                results.back().state = state;
+            }
+        }
+        int workers = runStates(job, data, results);
+
+        StateResult total;
+        long long stateNs = 0;
+        int placed = 0;
+        for (size_t s = 0; s < results.size(); s++) {
+            out << (s == 0 ? "\n    " : ",\n    ");
+            writeStateResult(out, results[s]);
+            total.stations += results[s].stations;
+            total.edges += results[s].edges;
+            stateNs += results[s].stateNs;
+            placed += results[s].placements.size();
+        }
+        long long wallNs = nanosecondsSince(jobStart);
+        // with states run side by side, state_ns adds up to more than the job's wall time
+        out << "\n  ], \"summary\": {\"states\": " << results.size() << ", \"stations\": " << total.stations
+            << ", \"edges\": " << total.edges << ", \"placements\": " << placed << ", \"workers\": " << workers
+            << ", \"state_ns_total\": " << stateNs << "}, \"total_ns\": " << wallNs << "}";
+    }
+    out << "\n]";
+    // with --stats, the phase timings and counters of the whole run come along
+    if (instrumentationEnabled()) {
+        out << ", \"instrumentation\": ";
+        writeInstrumentationJSON(out);
+    }
+    out << "}\n";
+
+    if (output.empty()) {
+        cout << out.str();
+        return 0;
+    }
+    ofstream file(output);
+    if (!file.is_open()) {
+        cerr << "Error: Could not open file " << output << endl;
+        return 1;
+    }
+    file << out.str();
+    return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_BATCH_H
+#define EV_CHARGING_STATION_OPTIMIZATION_BATCH_H
+
+#include <string>
+#include <vector>
+
+#include "graph.h"
+#include "placement.h"
+
+// One scripted run: the same placements made in each listed state, starting from the data file
+struct BatchJob {
+    std::vector<std::string> states = {"CA"};
+    PlacementAlgorithm algorithm = PlacementAlgorithm::Dijkstra;
+    int placements = 1;
+    double threshold = 2.0;
+    GraphMode mode = GraphMode::Threshold;
+    int k = 8;
+    std::string dataPath = "../data/openchargemap_data.csv";
+};
+
+// Sets one job option: states (comma separated), algorithm, placements, threshold, mode
+// (threshold or knn), k or data. Returns false and sets error if the key or value is invalid.
+bool applyBatchOption(const std::string& key, const std::string& value, BatchJob& job, std::string& error);
+
+// Headless mode. arguments are the command line after the program name:
+//   --states CA,TX --algorithm radix --placements 5 --threshold 2 --mode knn --k 8 --data FILE
+// set a single job, or --job FILE runs one job per line of FILE, written as key=value pairs
+// (e.g. "states=CA,TX algorithm=radix placements=5") on top of any options given.
+// Results and timings are written as JSON to stdout, or to --output FILE, and nothing else is
+// printed there; with --stats the instrumentation summary is included. Returns the process exit code.
+int runBatch(const std::vector<std::string>& arguments);
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_BATCH_H
@@ -0,0 +1,84 @@
+#include "batched_sssp.h"
+
+#include <queue>
+#include <limits>
+#include <algorithm>
+
+using namespace std;
+
+static_assert(BATCH_LANES <= 8, "pending lanes are tracked in one byte");
+
+namespace {
+const double INF = numeric_limits<double>::infinity();
+}
+
+BatchedSearch::BatchedSearch(const StationGraph& graph)
+        : graph(graph), dist(static_cast<size_t>(graph.size()) * BATCH_LANES, INF), pending(graph.size(), 0),
+          seen(graph.size(), 0) {}
+
+void BatchedSearch::run(const vector<int>& sources, double threshold) {
+    for (int u : touched) {
+        fill(dist.begin() + static_cast<size_t>(u) * BATCH_LANES, dist.begin() + static_cast<size_t>(u + 1) * BATCH_LANES, INF);
+        seen[u] = 0;
+    }
+    touched.clear();
+    int lanes = min(static_cast<int>(sources.size()), BATCH_LANES);
+    farthest.assign(lanes, 0.0);
+
+    // Label-correcting search ordered by each node's smallest improved distance. A node is
+    // expanded once per wave of improvements, and each expansion serves all improved lanes.
+    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<>> pq;
+    for (int lane = 0; lane < lanes; lane++) {
+        int s = sources[lane];
+        if (!seen[s]) {
+            seen[s] = 1;
+            touched.push_back(s);
+        }
+        dist[static_cast<size_t>(s) * BATCH_LANES + lane] = 0.0;
+        pending[s] |= static_cast<uint8_t>(1u << lane);
+        pq.push({0.0, s});
+    }
+
+    while (!pq.empty()) {
+        int u = pq.top().second;
+        pq.pop();
+        if (pending[u] == 0) {
+            continue;
+        }
+        pending[u] = 0;
+        const double* du = &dist[static_cast<size_t>(u) * BATCH_LANES];
+        int end = graph.prefixEnd(u, threshold);
+        for (int e = graph.offsets[u]; e < end; e++) {
+            int v = graph.targets[e];
+            double w = graph.weights[e];
+            double* dv = &dist[static_cast<size_t>(v) * BATCH_LANES];
+            if (!seen[v]) {
+                seen[v] = 1;
+                touched.push_back(v);
+            }
+            unsigned improved = 0;
+            double key = INF;
+            for (int l = 0; l < BATCH_LANES; l++) {
+                double candidate = du[l] + w;
+                if (candidate < dv[l]) {
+                    dv[l] = candidate;
+                    improved |= 1u << l;
+                    key = min(key, candidate);
+                }
+            }
+            if (improved != 0) {
+                pending[v] |= static_cast<uint8_t>(improved);
+                pq.push({key, v});
+            }
+        }
+    }
+
+    for (int u : touched) {
+        const double* du = &dist[static_cast<size_t>(u) * BATCH_LANES];
+        for (int lane = 0; lane < lanes; lane++) {
+            if (du[lane] != INF) {
+                farthest[lane] = max(farthest[lane], du[lane]);
+            }
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_BATCHED_SSSP_H
+#define EV_CHARGING_STATION_OPTIMIZATION_BATCHED_SSSP_H
+
+#include <vector>
+#include <cstdint>
+
+#include "graph.h"
+
+// Number of sources searched together in one pass
+const int BATCH_LANES = 8;
+
+// Shortest paths from up to BATCH_LANES sources in one traversal. Each node keeps one distance
+// per source side by side, so walking an adjacency list relaxes every source at once, and a
+// per-node bitmask records which sources improved since the node was last expanded.
+// Distances equal the ones a single-source Dijkstra computes.
+class BatchedSearch {
+public:
+    explicit BatchedSearch(const StationGraph& graph);
+
+    // sources are local indices, at most BATCH_LANES of them
+    void run(const std::vector<int>& sources, double threshold);
+
+    // Distance from sources[lane] to local index u after run(), infinity if unreachable
+    double distance(int lane, int u) const { return dist[static_cast<size_t>(u) * BATCH_LANES + lane]; }
+    // Largest finite distance per lane from the last run
+    const std::vector<double>& eccentricities() const { return farthest; }
+    // Nodes reached by any source in the last run
+    const std::vector<int>& reached() const { return touched; }
+
+private:
+    const StationGraph& graph;
+    std::vector<double> dist;      // BATCH_LANES distances per node
+    std::vector<uint8_t> pending;  // lanes improved since the node was last expanded
+    std::vector<char> seen;        // reached by any lane, to reset only those next run
+    std::vector<int> touched;
+    std::vector<double> farthest;
+};
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_BATCHED_SSSP_H
@@ -0,0 +1,324 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+
+#include "graph.h"
+#include "ingest.h"
+#include "synthetic.h"
+#include "shortest_paths.h"
+#include "route.h"
+#include "landmarks.h"
+#include "contraction_hierarchy.h"
+#include "parallel.h"
+#include "json.h"
+
+using namespace std;
+
+// Repeatable timings of graph construction and every shortest-path engine over real states and
+// synthetic station sets, written as JSON so runs can be compared across releases.
+//
+//   EV_Charging_Station_Benchmark [--csv FILE] [--states CA,TX] [--sizes 1000,10000]
+//                                 [--warmup N] [--reps N] [--threshold KM] [--threads N]
+//                                 [--output FILE]
+
+namespace {
+// Above these sizes the O(n^2) threshold build, the O(n m) Bellman-Ford and the
+// contraction hierarchy build take minutes per repetition, so those cases are skipped
+const int MAX_THRESHOLD_BUILD = 20000;
+const int MAX_BELLMAN_FORD = 50000;
+const int MAX_HIERARCHY = 20000;
+
+// Synthetic sets keep roughly the station density of a dense U.S. metro at every size
+const double SYNTHETIC_DENSITY = 0.5;  // stations per square km
+
+struct Options {
+    string csvFile = "../data/openchargemap_data.csv";
+    vector<string> states = {"CA", "TX", "FL", "NY", "WA"};
+    vector<int> sizes = {1000, 10000, 100000};
+    int warmup = 2;
+    int reps = 10;
+    double threshold = 2.0;
+    string output = "benchmark_results.json";
+};
+
+struct Result {
+    string dataset;
+    int stations;
+    long long edges;
+    string graphMode;
+    string name;
+    int reps;
+    long long minNs;
+    long long medianNs;
+    long long p99Ns;
+    double meanNs;
+};
+
+vector<string> splitList(const string& list) {
+    vector<string> items;
+    stringstream stream(list);
+    string item;
+    while (getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        string flag = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << flag << endl;
+            return false;
+        }
+        string value = argv[++i];
+        try {
+            if (flag == "--csv") {
+                options.csvFile = value;
+            } else if (flag == "--states") {
+                options.states = splitList(value);
+            } else if (flag == "--sizes") {
+                options.sizes.clear();
+                for (const string& size : splitList(value)) {
+                    options.sizes.push_back(stoi(size));
+                    // an empty set has no sources to sample
+                    if (options.sizes.back() < 1) {
+                        throw invalid_argument(value);
+                    }
+                }
+            } else if (flag == "--warmup") {
+                options.warmup = stoi(value);
+                if (options.warmup < 0) {
+                    throw invalid_argument(value);
+                }
+            } else if (flag == "--reps") {
+                options.reps = max(1, stoi(value));
+            } else if (flag == "--threshold") {
+                options.threshold = stod(value);
+                if (!(options.threshold > 0.0) || !isfinite(options.threshold)) {
+                    throw invalid_argument(value);
+                }
+            } else if (flag == "--threads") {
+                setWorkerCount(stoi(value));
+            } else if (flag == "--output") {
+                options.output = value;
+            } else {
+                cerr << "Unknown option " << flag << endl;
+                return false;
+            }
+        } catch (const logic_error&) {
+            cerr << "Invalid value for " << flag << ": " << value << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// One dataset's graph plus what its results are labelled with
+struct Dataset {
+    string name;
+    StationGraph graph;
+    double threshold = 0.0;
+};
+
+class Runner {
+public:
+    explicit Runner(const Options& options) : options(options) {}
+
+    // Calls run(rep) warmup times untimed, then reps times timed. rep counts from 0 over all
+    // calls, so inputs picked by rep differ between repetitions but not between runs.
+    void measure(const Dataset& data, const string& name, const function<void(int)>& run, int reps = -1) {
+        if (reps < 0) {
+            reps = options.reps;
+        }
+        int warmup = reps < options.reps ? 0 : options.warmup;
+        for (int i = 0; i < warmup; i++) {
+            run(i);
+        }
+        vector<long long> samples;
+        for (int i = 0; i < reps; i++) {
+            auto start = chrono::steady_clock::now();
+            run(warmup + i);
+            auto end = chrono::steady_clock::now();
+            samples.push_back(chrono::duration_cast<chrono::nanoseconds>(end - start).count());
+        }
+        sort(samples.begin(), samples.end());
+        double total = 0.0;
+        for (long long sample : samples) {
+            total += sample;
+        }
+
+        Result result;
+        result.dataset = data.name;
+        result.stations = data.graph.size();
+        result.edges = data.graph.edgeCount(data.threshold);
+        result.graphMode = graphModeName(data.graph.mode);
+        result.name = name;
+        result.reps = reps;
+        result.minNs = samples.front();
+        result.medianNs = samples[(samples.size() - 1) / 2];
+        // nearest-rank percentile
+        result.p99Ns = samples[static_cast<size_t>(ceil(0.99 * samples.size())) - 1];
+        result.meanNs = total / samples.size();
+        results.push_back(result);
+        cerr << "  " << name << ": median " << result.medianNs << " ns, p99 " << result.p99Ns << " ns" << endl;
+    }
+
+    // Times buildGraph, then labels the result with the graph it produced
+    void measureBuild(Dataset& data, const string& name, const vector<Node>& nodes, const GraphOptions& graphOptions) {
+        measure(data, name, [&](int) { buildGraph(nodes, graphOptions, data.graph); });
+        data.threshold = data.graph.maxRadius;
+        Result& result = results.back();
+        result.stations = data.graph.size();
+        result.edges = data.graph.edgeCount(data.threshold);
+        result.graphMode = graphModeName(data.graph.mode);
+    }
+
+    void runDataset(const string& name, const vector<Node>& nodes) {
+        int n = nodes.size();
+        cerr << name << " (" << n << " stations)" << endl;
+
+        // The engines run on the threshold graph when it is small enough to build, like the
+        // menu's default, and on the k-nearest graph otherwise
+        Dataset nearest;
+        nearest.name = name;
+        GraphOptions knn;
+        knn.mode = GraphMode::KNearest;
+        measureBuild(nearest, "build_graph_knn", nodes, knn);
+        if (n > MAX_THRESHOLD_BUILD) {
+            runEngines(nearest);
+            return;
+        }
+        Dataset data;
+        data.name = name;
+        GraphOptions threshold;
+        threshold.maxRadius = options.threshold;
+        measureBuild(data, "build_graph_threshold", nodes, threshold);
+        runEngines(data);
+    }
+
+    void runEngines(const Dataset& data) {
+        const StationGraph& graph = data.graph;
+        double threshold = data.threshold;
+        // fixed pseudo-random sources and targets among stations with an edge
+        vector<int> candidates;
+        for (int u = 0; u < graph.size(); u++) {
+            if (graph.degree(u, threshold) > 0) {
+                candidates.push_back(graph.nodes[u].id);
+            }
+        }
+        if (candidates.empty()) {
+            cerr << "  no station has an edge, skipping searches" << endl;
+            return;
+        }
+        mt19937 random(42);
+        vector<int> sources;
+        vector<int> targets;
+        for (int i = 0; i < options.warmup + options.reps; i++) {
+            sources.push_back(candidates[random() % candidates.size()]);
+            targets.push_back(candidates[random() % candidates.size()]);
+        }
+        int n = graph.size();
+
+        measure(data, "dijkstra_alg", [&](int rep) { dijkstra_alg(sources[rep], graph, threshold); });
+        measure(data, "dijkstra_radix", [&](int rep) { dijkstra_radix(sources[rep], graph, threshold); });
+        if (n <= MAX_BELLMAN_FORD) {
+            measure(data, "bellman_ford", [&](int rep) { bellman_ford(sources[rep], graph, threshold); });
+        }
+        measure(data, "bellman_ford_parallel", [&](int rep) { bellman_ford_parallel(sources[rep], graph, threshold); });
+        measure(data, "shortest_route", [&](int rep) { shortestRoute(graph, sources[rep], targets[rep], threshold); });
+
+        RangeSearch range(graph);
+        measure(data, "range_search_10km", [&](int rep) { range.within(sources[rep], 10.0, threshold); });
+
+        LandmarkOracle landmarks;
+        measure(data, "landmark_build", [&](int) { landmarks.build(graph, threshold); });
+        measure(data, "landmark_route", [&](int rep) { landmarks.route(graph, sources[rep], targets[rep]); });
+
+        if (n <= MAX_HIERARCHY) {
+            ContractionHierarchy hierarchy;
+            measure(data, "contraction_hierarchy_build", [&](int) { hierarchy.build(graph, threshold); },
+                    min(options.reps, 3));
+            measure(data, "contraction_hierarchy_route", [&](int rep) { hierarchy.route(sources[rep], targets[rep]); });
+        }
+    }
+
+    bool write() const {
+        ofstream out(options.output);
+        if (!out.is_open()) {
+            cerr << "Error: Could not open file " << options.output << endl;
+            return false;
+        }
+        out << "{\n";
+        out << "  \"warmup\": " << options.warmup << ",\n";
+        out << "  \"repetitions\": " << options.reps << ",\n";
+        out << "  \"threshold_km\": " << options.threshold << ",\n";
+        out << "  \"threads\": " << workerCount() << ",\n";
+        out << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            out << "    {\"dataset\": " << jsonQuote(r.dataset) << ", \"stations\": " << r.stations
+                << ", \"edges\": " << r.edges << ", \"graph_mode\": \"" << r.graphMode
+                << "\", \"case\": \"" << r.name << "\", \"repetitions\": " << r.reps
+                << ", \"min_ns\": " << r.minNs << ", \"median_ns\": " << r.medianNs
+                << ", \"p99_ns\": " << r.p99Ns << ", \"mean_ns\": " << static_cast<long long>(r.meanNs) << "}"
+                << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n";
+        out << "}\n";
+        return true;
+    }
+
+private:
+    const Options& options;
+    vector<Result> results;
+};
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+    Runner runner(options);
+    if (!options.states.empty()) {
+        vector<Node> allNodes;
+        if (loadStations(options.csvFile, allNodes)) {
+            collapseColocatedStations(allNodes, 0.025);
+            for (const string& state : options.states) {
+                vector<Node> nodes;
+                for (const Node& node : allNodes) {
+                    if (node.stateOrProvince == state) {
+                        nodes.push_back(node);
+                    }
+                }
+                if (nodes.empty()) {
+                    cerr << "No stations found in the specified state: " << state << endl;
+                    continue;
+                }
+                runner.runDataset(state, nodes);
+            }
+        } else {
+            cerr << "Error: Could not open file " << options.csvFile << ", running synthetic sets only" << endl;
+        }
+    }
+    for (int size : options.sizes) {
+        runner.runDataset("synthetic_" + to_string(size), uniformStations(size, SYNTHETIC_DENSITY, 1, "SY"));
+    }
+
+    if (!runner.write()) {
+        return 1;
+    }
+    cout << "Wrote " << options.output << endl;
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "server.h"
+
+#ifndef _WIN32
+
+#include <thread>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#endif
+
+using namespace std;
+
+// Sends request lines to a running server (see server.h) and prints its responses, one line
+// each, in the order they come back.
+//
+//   EV_Charging_Station_Client [--socket PATH] [--requests FILE]
+//
+// Requests are read from FILE, or from stdin if none is given, and all sent before the first
+// response is read, so a file of requests is answered concurrently.
+
+#ifndef _WIN32
+
+namespace {
+bool sendAll(int fd, const string& text) {
+    size_t written = 0;
+    while (written < text.size()) {
+        ssize_t n = write(fd, text.data() + written, text.size() - written);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+}
+
+int main(int argc, char* argv[]) {
+    string socketPath = DEFAULT_SOCKET;
+    string requestsFile;
+    for (int i = 1; i < argc; i++) {
+        string flag = argv[i];
+        if (i + 1 >= argc || (flag != "--socket" && flag != "--requests")) {
+            cerr << "Usage: " << argv[0] << " [--socket PATH] [--requests FILE]" << endl;
+            return 2;
+        }
+        (flag == "--socket" ? socketPath : requestsFile) = argv[++i];
+    }
+    ifstream file;
+    if (!requestsFile.empty()) {
+        file.open(requestsFile);
+        if (!file.is_open()) {
+            cerr << "Error: Could not open file " << requestsFile << endl;
+            return 1;
+        }
+    }
+    istream& requests = requestsFile.empty() ? cin : file;
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        cerr << "Error: Could not connect to " << socketPath << ": " << strerror(errno) << endl;
+        return 1;
+    }
+
+    // requests go out on their own thread, so a long file can't fill both directions and stall
+    thread sender([&requests, fd] {
+        string line;
+        while (getline(requests, line)) {
+            if (!sendAll(fd, line + "\n")) {
+                break;
+            }
+        }
+        // tells the server nothing more is coming; it closes once every answer is sent
+        shutdown(fd, SHUT_WR);
+    });
+
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        cout.write(buffer, n);
+        cout.flush();
+    }
+    // the server has closed; if it stopped early, the sender may still be waiting for input
+    sender.detach();
+    return 0;
+}
+
+#else
+
+int main() {
+    cerr << "The client needs Unix domain sockets, which this system does not have" << endl;
+    return 1;
+}
+
+#endif
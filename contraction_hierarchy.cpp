@@ -0,0 +1,541 @@
+#include "contraction_hierarchy.h"
+#include "instrumentation.h"
+
+#include <fstream>
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+using namespace std;
+
+namespace {
+const double INF = numeric_limits<double>::infinity();
+const char CH_MAGIC[4] = {'E', 'V', 'C', 'H'};
+const uint32_t CH_VERSION = 1;
+
+// FNV-1a over the station ids and coordinates plus the settings that decide the edges
+uint64_t graphFingerprint(const StationGraph& graph, double threshold) {
+    uint64_t hash = 1469598103934665603ULL;
+    auto mix = [&hash](const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+    };
+    int mode = static_cast<int>(graph.mode);
+    mix(&mode, sizeof(mode));
+    mix(&graph.k, sizeof(graph.k));
+    mix(&threshold, sizeof(threshold));
+    for (const Node& node : graph.nodes) {
+        mix(&node.id, sizeof(node.id));
+        mix(&node.latitude, sizeof(node.latitude));
+        mix(&node.longitude, sizeof(node.longitude));
+    }
+    return hash;
+}
+// Witness searches give up after this many settled nodes and add the shortcut instead
+const int WITNESS_SETTLE_LIMIT = 60;
+// Nodes with more remaining edges than this are left uncontracted in a top-level core, which
+// bounds preprocessing in very dense clusters; queries search the core like a plain graph
+const int CORE_DEGREE = 256;
+
+typedef priority_queue<pair<double, int>, vector<pair<double, int>>, greater<>> MinQueue;
+
+struct ContractEdge {
+    int to;
+    double weight;
+    int via;
+};
+
+struct Shortcut {
+    int from;
+    int to;
+    double weight;
+};
+
+// The remaining (uncontracted) graph while the hierarchy is built
+class Contractor {
+public:
+    Contractor(const StationGraph& graph, double threshold)
+            : adjacency(graph.size()), deletedNeighbors(graph.size(), 0), level(graph.size(), 0),
+              dist(graph.size(), INF), direct(graph.size(), INF) {
+        for (int u = 0; u < graph.size(); u++) {
+            int end = graph.prefixEnd(u, threshold);
+            for (int e = graph.offsets[u]; e < end; e++) {
+                adjacency[u].push_back({graph.targets[e], graph.weights[e], -1});
+            }
+        }
+    }
+
+    // Shortcuts that contracting v would need: for each pair of neighbors, unless a witness
+    // path avoiding v is at most as long as the path through v
+    vector<Shortcut> shortcutsFor(int v) {
+        vector<Shortcut> result;
+        const vector<ContractEdge>& edges = adjacency[v];
+        for (size_t i = 0; i < edges.size(); i++) {
+            int u = edges[i].to;
+            // A direct edge is the cheapest witness and, with straight-line weights, covers most
+            // pairs in dense clusters; only search when some neighbor is not directly connected
+            for (const ContractEdge& edge : adjacency[u]) {
+                direct[edge.to] = edge.weight;
+            }
+            double longest = -1.0;
+            for (size_t j = i + 1; j < edges.size(); j++) {
+                double through = edges[i].weight + edges[j].weight;
+                if (direct[edges[j].to] > through) {
+                    longest = max(longest, through);
+                }
+            }
+            if (longest >= 0.0) {
+                witnessSearch(u, v, longest);
+                for (size_t j = i + 1; j < edges.size(); j++) {
+                    double through = edges[i].weight + edges[j].weight;
+                    if (direct[edges[j].to] > through && dist[edges[j].to] > through) {
+                        result.push_back({u, edges[j].to, through});
+                    }
+                }
+            }
+            for (const ContractEdge& edge : adjacency[u]) {
+                direct[edge.to] = INF;
+            }
+        }
+        return result;
+    }
+
+    int degree(int v) const { return adjacency[v].size(); }
+    const vector<ContractEdge>& edges(int v) const { return adjacency[v]; }
+
+    // Edge difference plus already contracted neighbors; the shortcuts are kept in needed
+    int priority(int v, vector<Shortcut>& needed) {
+        needed = shortcutsFor(v);
+        return static_cast<int>(needed.size()) - static_cast<int>(adjacency[v].size()) + deletedNeighbors[v];
+    }
+
+    // Removes v, adds the shortcuts priority() found, and returns its remaining edges (all to higher ranks)
+    vector<ContractEdge> contract(int v, const vector<Shortcut>& needed) {
+        for (const Shortcut& shortcut : needed) {
+            addEdge(shortcut.from, shortcut.to, shortcut.weight, v);
+            addEdge(shortcut.to, shortcut.from, shortcut.weight, v);
+        }
+        vector<ContractEdge> upward;
+        upward.swap(adjacency[v]);
+        for (const ContractEdge& edge : upward) {
+            vector<ContractEdge>& other = adjacency[edge.to];
+            for (size_t i = 0; i < other.size(); i++) {
+                if (other[i].to == v) {
+                    other[i] = other.back();
+                    other.pop_back();
+                    break;
+                }
+            }
+            deletedNeighbors[edge.to]++;
+            level[edge.to] = max(level[edge.to], level[v] + 1);
+        }
+        return upward;
+    }
+
+private:
+    vector<vector<ContractEdge>> adjacency;
+    vector<int> deletedNeighbors;
+    vector<int> level;
+    vector<double> dist;
+    vector<int> touched;
+    vector<double> direct;  // weight of u's edge to each node while u's pairs are checked
+
+    void addEdge(int u, int w, double weight, int via) {
+        for (ContractEdge& edge : adjacency[u]) {
+            if (edge.to == w) {
+                if (weight < edge.weight) {
+                    edge.weight = weight;
+                    edge.via = via;
+                }
+                return;
+            }
+        }
+        adjacency[u].push_back({w, weight, via});
+    }
+
+    // Dijkstra from source in the remaining graph without skip, up to maxDist
+    void witnessSearch(int source, int skip, double maxDist) {
+        for (int u : touched) {
+            dist[u] = INF;
+        }
+        touched.clear();
+        dist[source] = 0.0;
+        touched.push_back(source);
+        MinQueue pq;
+        pq.push({0.0, source});
+        int settled = 0;
+        while (!pq.empty() && settled < WITNESS_SETTLE_LIMIT) {
+            pair<double, int> top = pq.top();
+            pq.pop();
+            if (top.first > dist[top.second]) {
+                continue;
+            }
+            if (top.first > maxDist) {
+                break;
+            }
+            settled++;
+            for (const ContractEdge& edge : adjacency[top.second]) {
+                if (edge.to == skip) {
+                    continue;
+                }
+                double newDist = top.first + edge.weight;
+                if (newDist < dist[edge.to]) {
+                    if (dist[edge.to] == INF) {
+                        touched.push_back(edge.to);
+                    }
+                    dist[edge.to] = newDist;
+                    pq.push({newDist, edge.to});
+                }
+            }
+        }
+    }
+};
+
+template <typename T>
+void writeArray(ofstream& out, const vector<T>& values) {
+    out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+template <typename T>
+bool readArray(ifstream& in, vector<T>& values, size_t count) {
+    values.resize(count);
+    in.read(reinterpret_cast<char*>(values.data()), count * sizeof(T));
+    return static_cast<bool>(in);
+}
+}
+
+void ContractionHierarchy::build(const StationGraph& graph, double threshold) {
+    ScopedTimer timer("hierarchy.build");
+    int n = graph.size();
+    this->threshold = threshold;
+    fingerprint = graphFingerprint(graph, threshold);
+    matchedGeneration = graph.generation;
+    matchedThreshold = threshold;
+    stationIds.resize(n);
+    index.clear();
+    for (int u = 0; u < n; u++) {
+        stationIds[u] = graph.nodes[u].id;
+        index[stationIds[u]] = u;
+    }
+    rank.assign(n, -1);
+    shortcuts = 0;
+
+    Contractor contractor(graph, threshold);
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<>> order;
+    vector<Shortcut> needed;
+    for (int u = 0; u < n; u++) {
+        order.push({contractor.degree(u) > CORE_DEGREE ? 0 : contractor.priority(u, needed), u});
+    }
+
+    // Lazy updates: a node's priority is recomputed when it reaches the top
+    vector<vector<ContractEdge>> upward(n);
+    vector<char> inCore(n, 0);
+    vector<int> core;
+    int next = 0;
+    while (!order.empty()) {
+        int v = order.top().second;
+        order.pop();
+        if (rank[v] != -1 || inCore[v]) {
+            continue;
+        }
+        if (contractor.degree(v) > CORE_DEGREE) {
+            inCore[v] = 1;
+            core.push_back(v);
+            continue;
+        }
+        int current = contractor.priority(v, needed);
+        if (!order.empty() && current > order.top().first) {
+            order.push({current, v});
+            continue;
+        }
+        upward[v] = contractor.contract(v, needed);
+        rank[v] = next++;
+    }
+    // The core shares the top rank and keeps every edge among itself in both directions
+    for (int v : core) {
+        upward[v] = contractor.edges(v);
+        rank[v] = next;
+    }
+
+    upOffsets.assign(n + 1, 0);
+    upTargets.clear();
+    upWeights.clear();
+    upVia.clear();
+    for (int u = 0; u < n; u++) {
+        for (const ContractEdge& edge : upward[u]) {
+            upTargets.push_back(edge.to);
+            upWeights.push_back(edge.weight);
+            upVia.push_back(edge.via);
+            if (edge.via != -1) {
+                shortcuts++;
+            }
+        }
+        upOffsets[u + 1] = upTargets.size();
+    }
+}
+
+int ContractionHierarchy::search(int s, int t, double& best, SearchWorkspace* sides[2], int& settled) const {
+    int n = stationIds.size();
+    SearchWorkspace& forward = *sides[0];
+    SearchWorkspace& backward = *sides[1];
+    forward.begin(n);
+    backward.begin(n);
+    forward.setDistance(s, 0.0);
+    backward.setDistance(t, 0.0);
+    forward.push(0.0, s);
+    backward.push(0.0, t);
+
+    best = INF;
+    settled = 0;
+    int meet = -1;
+    int side = 0;
+    while (true) {
+        // each direction stops on its own once it can no longer improve the best meeting
+        bool done[2];
+        for (int d = 0; d < 2; d++) {
+            done[d] = sides[d]->heapEmpty() || sides[d]->heapTop() >= best;
+        }
+        if (done[0] && done[1]) {
+            break;
+        }
+        if (done[side]) {
+            side = 1 - side;
+        }
+        SearchWorkspace& here = *sides[side];
+        SearchWorkspace& there = *sides[1 - side];
+        pair<double, int> top = here.pop();
+        int u = top.second;
+        if (top.first > here.distance(u)) {
+            continue;
+        }
+        settled++;
+        double other = there.distance(u);
+        if (other < INF && top.first + other < best) {
+            best = top.first + other;
+            meet = u;
+        }
+        // Stall-on-demand: if a higher node already reaches u for less, no shortest path
+        // continues upwards from u
+        bool stalled = false;
+        for (int e = upOffsets[u]; e < upOffsets[u + 1] && !stalled; e++) {
+            stalled = here.distance(upTargets[e]) + upWeights[e] < top.first;
+        }
+        if (stalled) {
+            side = 1 - side;
+            continue;
+        }
+        for (int e = upOffsets[u]; e < upOffsets[u + 1]; e++) {
+            int v = upTargets[e];
+            double newDist = top.first + upWeights[e];
+            if (newDist < here.distance(v)) {
+                // the parent slot holds the edge taken, which also names the node it came from
+                here.setDistance(v, newDist, e);
+                here.push(newDist, v);
+            }
+        }
+        side = 1 - side;
+    }
+    return meet;
+}
+
+double ContractionHierarchy::distance(int fromId, int toId) const {
+    auto from = index.find(fromId);
+    auto to = index.find(toId);
+    if (from == index.end() || to == index.end()) {
+        return INF;
+    }
+    double best;
+    int settled;
+    SearchWorkspace* sides[2] = {&localWorkspace(0), &localWorkspace(1)};
+    search(from->second, to->second, best, sides, settled);
+    return best;
+}
+
+int ContractionHierarchy::findEdge(int u, int v) const {
+    // the edge is stored with whichever end was contracted first
+    int low = rank[u] < rank[v] ? u : v;
+    int high = low == u ? v : u;
+    for (int e = upOffsets[low]; e < upOffsets[low + 1]; e++) {
+        if (upTargets[e] == high) {
+            return e;
+        }
+    }
+    return -1;
+}
+
+void ContractionHierarchy::unpack(int u, int v, vector<int>& path) const {
+    int e = findEdge(u, v);
+    if (e == -1 || upVia[e] == -1) {
+        path.push_back(stationIds[v]);
+        return;
+    }
+    unpack(u, upVia[e], path);
+    unpack(upVia[e], v, path);
+}
+
+Route ContractionHierarchy::route(int fromId, int toId) const {
+    ScopedTimer timer("route.contraction_hierarchy");
+    Route result;
+    auto from = index.find(fromId);
+    auto to = index.find(toId);
+    if (from == index.end() || to == index.end()) {
+        return result;
+    }
+    int s = from->second;
+    int t = to->second;
+    SearchWorkspace* sides[2] = {&localWorkspace(0), &localWorkspace(1)};
+    double best;
+    int meet = search(s, t, best, sides, result.settled);
+    if (meet == -1) {
+        return result;
+    }
+
+    // Hierarchy nodes from s up to the meeting node and back down to t
+    vector<int> forward;
+    for (int u = meet; u != s; ) {
+        forward.push_back(u);
+        int e = sides[0]->parent(u);
+        u = upper_bound(upOffsets.begin(), upOffsets.end(), e) - upOffsets.begin() - 1;
+    }
+    forward.push_back(s);
+    reverse(forward.begin(), forward.end());
+    for (int u = meet; u != t; ) {
+        int e = sides[1]->parent(u);
+        u = upper_bound(upOffsets.begin(), upOffsets.end(), e) - upOffsets.begin() - 1;
+        forward.push_back(u);
+    }
+
+    result.found = true;
+    result.distance = best;
+    result.path.push_back(stationIds[s]);
+    for (size_t i = 1; i < forward.size(); i++) {
+        unpack(forward[i - 1], forward[i], result.path);
+    }
+    return result;
+}
+
+bool ContractionHierarchy::matches(const StationGraph& graph, double threshold) const {
+    if (empty() || static_cast<int>(stationIds.size()) != graph.size()) {
+        return false;
+    }
+    // hashing every station is O(n), too much to repeat before every query on an unchanged graph
+    if (graph.generation == matchedGeneration && threshold == matchedThreshold) {
+        return true;
+    }
+    if (fingerprint != graphFingerprint(graph, threshold)) {
+        return false;
+    }
+    matchedGeneration = graph.generation;
+    matchedThreshold = threshold;
+    return true;
+}
+
+bool ContractionHierarchy::save(const string& path) const {
+    ofstream out(path, ios::binary);
+    if (!out.is_open()) {
+        return false;
+    }
+    int32_t n = stationIds.size();
+    int32_t m = upTargets.size();
+    int32_t shortcutTotal = shortcuts;
+    out.write(CH_MAGIC, sizeof(CH_MAGIC));
+    out.write(reinterpret_cast<const char*>(&CH_VERSION), sizeof(CH_VERSION));
+    out.write(reinterpret_cast<const char*>(&threshold), sizeof(threshold));
+    out.write(reinterpret_cast<const char*>(&fingerprint), sizeof(fingerprint));
+    out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    out.write(reinterpret_cast<const char*>(&m), sizeof(m));
+    out.write(reinterpret_cast<const char*>(&shortcutTotal), sizeof(shortcutTotal));
+    writeArray(out, stationIds);
+    writeArray(out, rank);
+    writeArray(out, upOffsets);
+    writeArray(out, upTargets);
+    writeArray(out, upWeights);
+    writeArray(out, upVia);
+    return static_cast<bool>(out);
+}
+
+bool ContractionHierarchy::load(const string& path, const StationGraph& graph, double threshold) {
+    ifstream in(path, ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    char magic[4];
+    uint32_t version;
+    double savedThreshold;
+    uint64_t savedFingerprint;
+    int32_t n, m, shortcutTotal;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    in.read(reinterpret_cast<char*>(&savedThreshold), sizeof(savedThreshold));
+    in.read(reinterpret_cast<char*>(&savedFingerprint), sizeof(savedFingerprint));
+    in.read(reinterpret_cast<char*>(&n), sizeof(n));
+    in.read(reinterpret_cast<char*>(&m), sizeof(m));
+    in.read(reinterpret_cast<char*>(&shortcutTotal), sizeof(shortcutTotal));
+    if (!in || memcmp(magic, CH_MAGIC, sizeof(magic)) != 0 || version != CH_VERSION || n != graph.size() ||
+        m < 0 || savedThreshold != threshold || savedFingerprint != graphFingerprint(graph, threshold)) {
+        stationIds.clear();
+        return false;
+    }
+    // the arrays must fill the rest of the file exactly, so a corrupt count never gets allocated
+    streamoff start = in.tellg();
+    in.seekg(0, ios::end);
+    streamoff remaining = in.tellg() - start;
+    in.seekg(start);
+    long long expected = static_cast<long long>(n) * (2 * sizeof(int)) + (n + 1LL) * sizeof(int) +
+                         static_cast<long long>(m) * (2 * sizeof(int) + sizeof(double));
+    if (!in || remaining != expected) {
+        stationIds.clear();
+        return false;
+    }
+    this->threshold = savedThreshold;
+    fingerprint = savedFingerprint;
+    if (!readArray(in, stationIds, n) || !readArray(in, rank, n) || !readArray(in, upOffsets, n + 1) ||
+        !readArray(in, upTargets, m) || !readArray(in, upWeights, m) || !readArray(in, upVia, m)) {
+        stationIds.clear();
+        return false;
+    }
+    index.clear();
+    for (int u = 0; u < n; u++) {
+        index[stationIds[u]] = u;
+    }
+    if (!validLayout() || static_cast<int>(index.size()) != n || shortcutTotal < 0 || shortcutTotal > m) {
+        stationIds.clear();
+        index.clear();
+        return false;
+    }
+    shortcuts = shortcutTotal;
+    matchedGeneration = graph.generation;
+    matchedThreshold = threshold;
+    return true;
+}
+
+bool ContractionHierarchy::validLayout() const {
+    int n = stationIds.size();
+    int m = upTargets.size();
+    if (upOffsets[0] != 0 || upOffsets[n] != m) {
+        return false;
+    }
+    for (int u = 0; u < n; u++) {
+        if (rank[u] < 0 || rank[u] >= n || upOffsets[u + 1] < upOffsets[u]) {
+            return false;
+        }
+    }
+    for (int u = 0; u < n; u++) {
+        for (int e = upOffsets[u]; e < upOffsets[u + 1]; e++) {
+            int v = upTargets[e];
+            int via = upVia[e];
+            if (v < 0 || v >= n || !(upWeights[e] >= 0.0)) {
+                return false;
+            }
+            // a shortcut skips a node contracted before both its ends, so unpacking always ends
+            if (via != -1 && (via < 0 || via >= n || rank[via] >= rank[u] || rank[via] >= rank[v])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_CONTRACTION_HIERARCHY_H
+#define EV_CHARGING_STATION_OPTIMIZATION_CONTRACTION_HIERARCHY_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+#include "graph.h"
+#include "route.h"
+#include "search_workspace.h"
+
+// Contraction hierarchy over one state's graph at a fixed threshold, for fast repeated
+// station-to-station queries. Stations are contracted least important first (by edge
+// difference plus already contracted neighbors); shortcuts keep shortest distances among the
+// rest. A query then only searches upwards in the order from both ends.
+class ContractionHierarchy {
+public:
+    void build(const StationGraph& graph, double threshold);
+
+    // Shortest distance in km, or infinity if the stations are not connected
+    double distance(int fromId, int toId) const;
+    // Shortest route with shortcuts unpacked back into station-to-station legs
+    Route route(int fromId, int toId) const;
+
+    // Whether this hierarchy was built from the same stations, graph mode and threshold. Once a
+    // graph matches, later checks against the same build of it are O(1).
+    bool matches(const StationGraph& graph, double threshold) const;
+
+    // Binary file with the order and upward edges. load only takes a file saved for this graph and
+    // threshold, checking its sizes against the graph and the file before reading any further, and
+    // returns false on I/O or format errors, including offsets, targets or shortcut nodes out of range
+    bool save(const std::string& path) const;
+    bool load(const std::string& path, const StationGraph& graph, double threshold);
+
+    bool empty() const { return stationIds.empty(); }
+    int shortcutCount() const { return shortcuts; }
+
+private:
+    double threshold = 0.0;
+    uint64_t fingerprint = 0;             // of the stations and graph settings it was built from
+    // StationGraph::generation and threshold last found to match; not safe for concurrent checks
+    mutable unsigned long long matchedGeneration = 0;
+    mutable double matchedThreshold = 0.0;
+    std::vector<int> stationIds;          // local index -> station id
+    std::unordered_map<int, int> index;   // station id -> local index
+    std::vector<int> rank;                // contraction order
+    // Edges from each node to higher ranked nodes. via is the contracted node a shortcut
+    // skips over, or -1 for an edge of the original graph.
+    std::vector<int> upOffsets;
+    std::vector<int> upTargets;
+    std::vector<double> upWeights;
+    std::vector<int> upVia;
+    int shortcuts = 0;
+
+    // Upward search from both ends in the two workspaces; returns the meeting node or -1.
+    // Each reached node's parent is the upward edge it was reached by.
+    int search(int s, int t, double& best, SearchWorkspace* sides[2], int& settled) const;
+    int findEdge(int u, int v) const;
+    // Whether the loaded arrays describe a hierarchy over stationIds.size() nodes
+    bool validLayout() const;
+    void unpack(int u, int v, std::vector<int>& path) const;
+};
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_CONTRACTION_HIERARCHY_H
@@ -0,0 +1,137 @@
+#include "diameter.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "shortest_paths.h"
+#include "instrumentation.h"
+
+using namespace std;
+
+namespace {
+const double INF = numeric_limits<double>::infinity();
+
+// Runs Dijkstra from source inside one component and returns the farthest settled node.
+// dist and parent hold the result until the next call; only the previous run's nodes are reset.
+class ComponentSearch {
+public:
+    ComponentSearch(const StationGraph& graph, double threshold)
+            : graph(graph), threshold(threshold), dist(graph.size(), INF), parent(graph.size(), -1) {}
+
+    int run(int source) {
+        for (int u : touched) {
+            dist[u] = INF;
+        }
+        touched = dijkstra_distances(source, graph, threshold, dist, &parent);
+        searches++;
+        int farthest = source;
+        for (int u : touched) {
+            if (dist[u] > dist[farthest]) {
+                farthest = u;
+            }
+        }
+        return farthest;
+    }
+
+    const StationGraph& graph;
+    double threshold;
+    vector<double> dist;
+    vector<int> parent;
+    vector<int> touched;
+    int searches = 0;
+};
+
+FarthestPair componentDiameter(ComponentSearch& search, int start) {
+    const StationGraph& graph = search.graph;
+    search.searches = 0;
+
+    // Double sweep: the farthest node from anywhere, then the farthest from that
+    int a = search.run(start);
+    int b = search.run(a);
+    double lowerBound = search.dist[b];
+    int bestFrom = a, bestTo = b;
+
+    // Start iFUB from the node halfway along the a-b path
+    int middle = b;
+    double middleScore = INF;
+    for (int u = b; u != -1; u = search.parent[u]) {
+        double score = max(search.dist[u], lowerBound - search.dist[u]);
+        if (score < middleScore) {
+            middleScore = score;
+            middle = u;
+        }
+    }
+    int farthestFromMiddle = search.run(middle);
+    if (search.dist[farthestFromMiddle] > lowerBound) {
+        lowerBound = search.dist[farthestFromMiddle];
+        bestFrom = middle;
+        bestTo = farthestFromMiddle;
+    }
+
+    // Visit nodes farthest from the middle first. Every pair among the nodes not yet visited
+    // is within 2 * (their largest distance to the middle), so stop once that can't beat the bound.
+    vector<pair<double, int>> fringe;
+    fringe.reserve(search.touched.size());
+    for (int u : search.touched) {
+        fringe.push_back({search.dist[u], u});
+    }
+    int componentSize = fringe.size();
+    sort(fringe.begin(), fringe.end(), greater<pair<double, int>>());
+    for (const auto& entry : fringe) {
+        if (lowerBound >= 2 * entry.first) {
+            break;
+        }
+        int farthest = search.run(entry.second);
+        if (search.dist[farthest] > lowerBound) {
+            lowerBound = search.dist[farthest];
+            bestFrom = entry.second;
+            bestTo = farthest;
+        }
+    }
+
+    FarthestPair result;
+    result.from = graph.nodes[bestFrom].id;
+    result.to = graph.nodes[bestTo].id;
+    result.distance = lowerBound;
+    result.componentSize = componentSize;
+    result.searches = search.searches;
+    return result;
+}
+}
+
+vector<FarthestPair> componentDiameters(const StationGraph& graph, double threshold) {
+    vector<int> component;
+    int count = connectedComponents(graph, threshold, component);
+    vector<int> start(count, -1);
+    vector<int> size(count, 0);
+    for (int u = 0; u < graph.size(); u++) {
+        if (start[component[u]] == -1) {
+            start[component[u]] = u;
+        }
+        size[component[u]]++;
+    }
+
+    vector<FarthestPair> results;
+    ComponentSearch search(graph, threshold);
+    for (int c = 0; c < count; c++) {
+        if (size[c] < 2) {
+            continue;
+        }
+        results.push_back(componentDiameter(search, start[c]));
+    }
+    return results;
+}
+
+FarthestPair graphDiameter(const StationGraph& graph, double threshold) {
+    ScopedTimer timer("search.farthest_pair");
+    FarthestPair best;
+    int searches = 0;
+    for (const FarthestPair& pair : componentDiameters(graph, threshold)) {
+        searches += pair.searches;
+        if (pair.distance > best.distance) {
+            best = pair;
+        }
+    }
+    best.searches = searches;
+    return best;
+}
@@ -0,0 +1,26 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_DIAMETER_H
+#define EV_CHARGING_STATION_OPTIMIZATION_DIAMETER_H
+
+#include <vector>
+
+#include "graph.h"
+
+// Two stations at the largest shortest-path distance in a component
+struct FarthestPair {
+    int from = -1;          // station ids
+    int to = -1;
+    double distance = 0.0;  // km
+    int componentSize = 0;
+    int searches = 0;       // single-source searches it took to prove the pair
+};
+
+// Exact farthest pair of every connected component with at least two stations.
+// A double sweep gives a lower bound and a central start node; iFUB then computes
+// eccentricities from the fringe inwards and stops once no remaining pair can beat
+// the bound, which usually takes a handful of searches instead of one per station.
+std::vector<FarthestPair> componentDiameters(const StationGraph& graph, double threshold);
+
+// The farthest pair over all components (from == -1 if the graph has no edges)
+FarthestPair graphDiameter(const StationGraph& graph, double threshold);
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_DIAMETER_H
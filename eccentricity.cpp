@@ -0,0 +1,191 @@
+#include "eccentricity.h"
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+#include "shortest_paths.h"
+#include "instrumentation.h"
+#include "parallel.h"
+#include "batched_sssp.h"
+
+using namespace std;
+
+namespace {
+const double INF = numeric_limits<double>::infinity();
+const double EPS = 1e-9;
+
+// A distance buffer for one worker; only the nodes the last search reached are reset
+struct SearchBuffer {
+    vector<double> dist;
+    vector<int> touched;
+
+    double run(int source, const StationGraph& graph, double threshold) {
+        if (dist.empty()) {
+            dist.assign(graph.size(), INF);
+        }
+        for (int u : touched) {
+            dist[u] = INF;
+        }
+        touched = dijkstra_distances(source, graph, threshold, dist);
+        double eccentricity = 0.0;
+        for (int u : touched) {
+            eccentricity = max(eccentricity, dist[u]);
+        }
+        return eccentricity;
+    }
+};
+
+void exhaustive(const StationGraph& graph, double threshold, EccentricityReport& report) {
+    int n = graph.size();
+    parallelFor(0, n, [&](int begin, int end) {
+        SearchBuffer buffer;
+        for (int u = begin; u < end; u++) {
+            report.eccentricity[u] = buffer.run(u, graph, threshold);
+        }
+    });
+    report.searches = n;
+}
+
+void batched(const StationGraph& graph, double threshold, EccentricityReport& report) {
+    int n = graph.size();
+    int batches = (n + BATCH_LANES - 1) / BATCH_LANES;
+    parallelFor(0, batches, [&](int begin, int end) {
+        BatchedSearch search(graph);
+        vector<int> sources;
+        for (int b = begin; b < end; b++) {
+            sources.clear();
+            for (int u = b * BATCH_LANES; u < n && u < (b + 1) * BATCH_LANES; u++) {
+                sources.push_back(u);
+            }
+            search.run(sources, threshold);
+            for (int lane = 0; lane < static_cast<int>(sources.size()); lane++) {
+                report.eccentricity[sources[lane]] = search.eccentricities()[lane];
+            }
+        }
+    });
+    report.searches = batches;
+}
+
+void bounded(const StationGraph& graph, double threshold, EccentricityReport& report) {
+    int n = graph.size();
+    vector<double> lower(n, 0.0);
+    vector<double> upper(n, INF);
+    vector<char> resolved(n, 0);
+    int unresolved = n;
+    for (int u = 0; u < n; u++) {
+        if (graph.degree(u, threshold) == 0) {
+            resolved[u] = 1;
+            unresolved--;
+        }
+    }
+
+    int batchSize = workerCount();
+    vector<SearchBuffer> buffers(batchSize);
+    vector<int> batch;
+    vector<double> batchEccentricity(batchSize);
+    bool pickUpper = true;
+    while (unresolved > 0) {
+        // Alternate between the largest upper bound and the smallest lower bound, which
+        // tightens the periphery and the center respectively
+        batch.clear();
+        vector<char> chosen(n, 0);
+        while (static_cast<int>(batch.size()) < batchSize && static_cast<int>(batch.size()) < unresolved) {
+            int pick = -1;
+            for (int u = 0; u < n; u++) {
+                if (resolved[u] || chosen[u]) {
+                    continue;
+                }
+                if (pick == -1 ||
+                    (pickUpper && (upper[u] > upper[pick] || (upper[u] == upper[pick] && lower[u] < lower[pick]))) ||
+                    (!pickUpper && (lower[u] < lower[pick] || (lower[u] == lower[pick] && upper[u] > upper[pick])))) {
+                    pick = u;
+                }
+            }
+            chosen[pick] = 1;
+            batch.push_back(pick);
+            pickUpper = !pickUpper;
+        }
+
+        int batchCount = batch.size();
+        parallelFor(0, batchCount, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                batchEccentricity[i] = buffers[i].run(batch[i], graph, threshold);
+            }
+        });
+        report.searches += batchCount;
+
+        for (int i = 0; i < batchCount; i++) {
+            int v = batch[i];
+            double eccentricity = batchEccentricity[i];
+            lower[v] = upper[v] = eccentricity;
+            for (int w : buffers[i].touched) {
+                double d = buffers[i].dist[w];
+                lower[w] = max(lower[w], max(d, eccentricity - d));
+                upper[w] = min(upper[w], eccentricity + d);
+            }
+        }
+        for (int i = 0; i < batchCount; i++) {
+            for (int w : buffers[i].touched) {
+                if (!resolved[w] && upper[w] - lower[w] <= EPS) {
+                    resolved[w] = 1;
+                    unresolved--;
+                }
+            }
+        }
+    }
+
+    for (int u = 0; u < n; u++) {
+        report.eccentricity[u] = graph.degree(u, threshold) == 0 ? 0.0 : lower[u];
+    }
+}
+}
+
+EccentricityReport allEccentricities(const StationGraph& graph, double threshold, EccentricityMethod method) {
+    ScopedTimer timer("search.eccentricity");
+    EccentricityReport report;
+    int n = graph.size();
+    report.eccentricity.assign(n, 0.0);
+    report.componentCount = connectedComponents(graph, threshold, report.component);
+    if (n == 0) {
+        return report;
+    }
+
+    if (method == EccentricityMethod::Bounded) {
+        bounded(graph, threshold, report);
+    } else if (method == EccentricityMethod::Batched) {
+        batched(graph, threshold, report);
+    } else {
+        exhaustive(graph, threshold, report);
+    }
+
+    // Center and periphery of the largest component
+    vector<int> sizes(report.componentCount, 0);
+    for (int c : report.component) {
+        sizes[c]++;
+    }
+    int largest = max_element(sizes.begin(), sizes.end()) - sizes.begin();
+    report.largestComponentSize = sizes[largest];
+    report.radius = INF;
+    report.diameter = 0.0;
+    for (int u = 0; u < n; u++) {
+        if (report.component[u] == largest) {
+            report.radius = min(report.radius, report.eccentricity[u]);
+            report.diameter = max(report.diameter, report.eccentricity[u]);
+        }
+    }
+    for (int u = 0; u < n; u++) {
+        if (report.component[u] != largest) {
+            continue;
+        }
+        if (fabs(report.eccentricity[u] - report.radius) <= EPS) {
+            report.center.push_back(graph.nodes[u].id);
+        }
+        if (fabs(report.eccentricity[u] - report.diameter) <= EPS) {
+            report.periphery.push_back(graph.nodes[u].id);
+        }
+    }
+    sort(report.center.begin(), report.center.end());
+    sort(report.periphery.begin(), report.periphery.end());
+    return report;
+}
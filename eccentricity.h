@@ -0,0 +1,34 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_ECCENTRICITY_H
+#define EV_CHARGING_STATION_OPTIMIZATION_ECCENTRICITY_H
+
+#include <vector>
+
+#include "graph.h"
+
+// Eccentricity of every station within its connected component, plus the center
+// (smallest eccentricity) and periphery (largest) of the state's largest component
+struct EccentricityReport {
+    std::vector<double> eccentricity;  // by local index, km
+    std::vector<int> component;        // by local index
+    int componentCount = 0;
+    int largestComponentSize = 0;
+    double radius = 0.0;               // of the largest component
+    double diameter = 0.0;
+    std::vector<int> center;           // station ids
+    std::vector<int> periphery;
+    int searches = 0;
+};
+
+enum class EccentricityMethod {
+    PerSource,  // one Dijkstra per station
+    Batched,    // BATCH_LANES stations per traversal (see batched_sssp.h)
+    Bounded     // searches only until lower and upper eccentricity bounds meet
+};
+
+// Runs the searches across all workers, each reusing its own distance buffer. With Bounded,
+// stations are picked in batches and every search tightens lower/upper eccentricity bounds of
+// the rest of its component, and only stations whose bounds have not met still need a search
+// of their own.
+EccentricityReport allEccentricities(const StationGraph& graph, double threshold, EccentricityMethod method);
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_ECCENTRICITY_H
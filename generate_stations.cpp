@@ -0,0 +1,112 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cmath>
+
+#include "synthetic.h"
+
+using namespace std;
+
+// Writes a synthetic station CSV that the menu program and the benchmark load like the real
+// Open Charge Map export, for scaling tests without the real data.
+//
+//   EV_Charging_Station_Generator [--count N] [--layout uniform|clustered] [--density PER_KM2]
+//                                 [--clusters N] [--cluster-radius KM] [--rural FRACTION]
+//                                 [--seed N] [--state CA] [--center LAT,LON] [--output FILE]
+
+namespace {
+bool parseOptions(int argc, char* argv[], SyntheticOptions& options, string& output) {
+    for (int i = 1; i < argc; i++) {
+        string flag = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << flag << endl;
+            return false;
+        }
+        string value = argv[++i];
+        try {
+            if (flag == "--count") {
+                options.count = stoll(value);
+            } else if (flag == "--layout") {
+                if (value == "uniform") {
+                    options.layout = StationLayout::Uniform;
+                } else if (value == "clustered") {
+                    options.layout = StationLayout::Clustered;
+                } else {
+                    cerr << "Layout must be uniform or clustered" << endl;
+                    return false;
+                }
+            } else if (flag == "--density") {
+                options.stationsPerKm2 = stod(value);
+            } else if (flag == "--clusters") {
+                options.clusters = stoi(value);
+            } else if (flag == "--cluster-radius") {
+                options.clusterRadiusKm = stod(value);
+            } else if (flag == "--rural") {
+                options.ruralFraction = stod(value);
+            } else if (flag == "--seed") {
+                options.seed = static_cast<unsigned>(stoul(value));
+            } else if (flag == "--state") {
+                options.state = value;
+            } else if (flag == "--center") {
+                size_t comma = value.find(',');
+                if (comma == string::npos) {
+                    cerr << "Center must be LAT,LON" << endl;
+                    return false;
+                }
+                options.centerLat = stod(value.substr(0, comma));
+                options.centerLon = stod(value.substr(comma + 1));
+            } else if (flag == "--output") {
+                output = value;
+            } else {
+                cerr << "Unknown option " << flag << endl;
+                return false;
+            }
+        } catch (const logic_error&) {
+            cerr << "Invalid value for " << flag << ": " << value << endl;
+            return false;
+        }
+    }
+    // station ids are ints
+    if (options.count < 0 || options.count > 2000000000LL || !(options.stationsPerKm2 > 0.0) ||
+        !isfinite(options.stationsPerKm2)) {
+        cerr << "Count must be between 0 and 2000000000 and density positive" << endl;
+        return false;
+    }
+    // any of these not finite would put nan coordinates in the file
+    if (!isfinite(options.centerLat) || !isfinite(options.centerLon) || !isfinite(options.clusterRadiusKm) ||
+        !isfinite(options.ruralFraction)) {
+        cerr << "Center, cluster radius and rural fraction must be finite numbers" << endl;
+        return false;
+    }
+    return true;
+}
+}
+
+int main(int argc, char* argv[]) {
+    SyntheticOptions options;
+    string output = "synthetic_stations.csv";
+    if (!parseOptions(argc, argv, options, output)) {
+        return 1;
+    }
+
+    // the buffer has to be set before the file is opened, or libstdc++ ignores it
+    vector<char> buffer(1 << 20);
+    ofstream file;
+    file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    file.open(output, ios::binary);
+    if (!file.is_open()) {
+        cerr << "Error: Could not open file " << output << endl;
+        return 1;
+    }
+
+    long long rows = writeStationsCSV(options, file);
+    file.close();
+    if (file.fail()) {
+        cerr << "Error: Could not write " << output << endl;
+        return 1;
+    }
+    cout << "Wrote " << rows << " stations in " << options.state << " to " << output << endl;
+    return 0;
+}
@@ -0,0 +1,275 @@
+#include "graph.h"
+#include "spatial_index.h"
+#include "parallel.h"
+#include "instrumentation.h"
+
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+
+using namespace std;
+
+double haversine(double latitude, double longitude, double latitude_two, double longitude_two) {
+    const double DEG_TO_RAD = M_PI / 180.0;
+    latitude *= DEG_TO_RAD;
+    longitude *= DEG_TO_RAD;
+    latitude_two *= DEG_TO_RAD;
+    longitude_two *= DEG_TO_RAD;
+    double dlat = latitude_two - latitude;
+    double dlon = longitude_two - longitude;
+    double a = sin(dlat / 2) * sin(dlat / 2) +
+               cos(latitude) * cos(latitude_two) *
+               sin(dlon / 2) * sin(dlon / 2);
+    double c = 2 * atan2(sqrt(a), sqrt(1 - a));
+    double distance = earthR * c;
+    return distance;
+}
+
+int StationGraph::localIndex(int id) const {
+    auto it = index.find(id);
+    if (it == index.end()) {
+        return -1;
+    }
+    return it->second;
+}
+
+int StationGraph::prefixEnd(int u, double threshold) const {
+    if (threshold >= maxRadius) {
+        return ends[u];
+    }
+    // weights are ascending within a node, so the prefix ends at the first edge longer than threshold
+    auto first = weights.begin() + offsets[u];
+    auto last = weights.begin() + ends[u];
+    return static_cast<int>(upper_bound(first, last, threshold) - weights.begin());
+}
+
+long long StationGraph::edgeCount(double threshold) const {
+    long long count = 0;
+    for (int u = 0; u < size(); u++) {
+        count += degree(u, threshold);
+    }
+    // each edge is stored in both directions
+    return count / 2;
+}
+
+namespace {
+atomic<unsigned long long> graphGenerations(0);
+}
+
+void StationGraph::clear() {
+    generation = ++graphGenerations;
+    mode = GraphMode::Threshold;
+    k = 0;
+    maxRadius = 0.0;
+    nodes.clear();
+    index.clear();
+    offsets.clear();
+    ends.clear();
+    limits.clear();
+    targets.clear();
+    weights.clear();
+}
+
+int StationGraph::insert(const Node& station, const vector<pair<double, int>>& neighbors) {
+    ScopedTimer timer("graph.insert");
+    int v = size();
+    nodes.push_back(station);
+    index[station.id] = v;
+    vector<pair<double, int>> edges;
+    for (const auto& edge : neighbors) {
+        if (edge.first <= maxRadius && edge.second != v) {
+            edges.push_back(edge);
+        }
+    }
+    // ties in the order a build would give them, with v after every older station
+    sort(edges.begin(), edges.end());
+    offsets.push_back(static_cast<int>(targets.size()));
+    for (const auto& edge : edges) {
+        weights.push_back(edge.first);
+        targets.push_back(edge.second);
+    }
+    ends.push_back(static_cast<int>(targets.size()));
+    limits.push_back(static_cast<int>(targets.size()));
+    for (const auto& edge : edges) {
+        addEdge(edge.second, v, edge.first);
+    }
+    generation = ++graphGenerations;
+    addCount("graph.edges_inserted", static_cast<long long>(edges.size()));
+    return v;
+}
+
+void StationGraph::addEdge(int u, int v, double distance) {
+    if (ends[u] == limits[u]) {
+        // double the room, so a list that keeps growing moves O(1) times per edge on average
+        int degree = ends[u] - offsets[u];
+        int start = static_cast<int>(targets.size());
+        int room = max(4, 2 * degree);
+        targets.resize(start + room);
+        weights.resize(start + room);
+        copy(targets.begin() + offsets[u], targets.begin() + ends[u], targets.begin() + start);
+        copy(weights.begin() + offsets[u], weights.begin() + ends[u], weights.begin() + start);
+        offsets[u] = start;
+        ends[u] = start + degree;
+        limits[u] = start + room;
+    }
+    // insertion sort into place; an equal length stays ahead, as v is the newest station
+    int e = ends[u]++;
+    while (e > offsets[u] && weights[e - 1] > distance) {
+        weights[e] = weights[e - 1];
+        targets[e] = targets[e - 1];
+        e--;
+    }
+    weights[e] = distance;
+    targets[e] = v;
+}
+
+int connectedComponents(const StationGraph& graph, double threshold, vector<int>& component) {
+    int n = graph.size();
+    component.assign(n, -1);
+    int count = 0;
+    vector<int> stack;
+    for (int start = 0; start < n; start++) {
+        if (component[start] != -1) {
+            continue;
+        }
+        component[start] = count;
+        stack.push_back(start);
+        while (!stack.empty()) {
+            int u = stack.back();
+            stack.pop_back();
+            int end = graph.prefixEnd(u, threshold);
+            for (int e = graph.offsets[u]; e < end; e++) {
+                int v = graph.targets[e];
+                if (component[v] == -1) {
+                    component[v] = count;
+                    stack.push_back(v);
+                }
+            }
+        }
+        count++;
+    }
+    return count;
+}
+
+namespace {
+// Sorts each node's (distance, neighbor) list and packs all of them into the graph's flat arrays
+void flattenAdjacency(vector<vector<pair<double, int>>>& adjacency, size_t edgeSlots, StationGraph& graph) {
+    int numNodes = adjacency.size();
+    graph.offsets.assign(numNodes, 0);
+    graph.ends.assign(numNodes, 0);
+    graph.targets.reserve(edgeSlots);
+    graph.weights.reserve(edgeSlots);
+    for (int i = 0; i < numNodes; i++) {
+        graph.offsets[i] = static_cast<int>(graph.targets.size());
+        sort(adjacency[i].begin(), adjacency[i].end());
+        for (const auto& edge : adjacency[i]) {
+            graph.weights.push_back(edge.first);
+            graph.targets.push_back(edge.second);
+        }
+        graph.ends[i] = static_cast<int>(graph.targets.size());
+        vector<pair<double, int>>().swap(adjacency[i]);
+    }
+    // packed with no room to spare; insert moves a list out the first time it grows
+    graph.limits = graph.ends;
+}
+}
+
+// Function to build the graph
+void buildGraph(const vector<Node>& nodes, double maxRadius, StationGraph& graph) {
+    int numNodes = nodes.size();
+    int edgeCount = 0;
+
+    graph.clear();
+    graph.maxRadius = maxRadius;
+    graph.nodes = nodes;
+    for (int i = 0; i < numNodes; i++) {
+        graph.index[nodes[i].id] = i;
+    }
+
+    vector<vector<pair<double, int>>> adjacency(numNodes);
+    for (int i = 0; i < numNodes; i++) {
+        const Node& node = nodes[i];
+        for (int j = i + 1; j < numNodes; j++) {
+            const Node& otherNode = nodes[j];
+            double distance = haversine(node.latitude, node.longitude, otherNode.latitude, otherNode.longitude);
+            if (distance <= maxRadius) {
+                adjacency[i].push_back({distance, j});
+                adjacency[j].push_back({distance, i});
+                edgeCount++;
+            }
+        }
+    }
+
+    flattenAdjacency(adjacency, 2 * static_cast<size_t>(edgeCount), graph);
+    addCount("graph.edges_built", edgeCount);
+}
+
+void buildKNearestGraph(const vector<Node>& nodes, int k, StationGraph& graph) {
+    int numNodes = nodes.size();
+
+    graph.clear();
+    graph.mode = GraphMode::KNearest;
+    graph.k = k;
+    graph.nodes = nodes;
+    for (int i = 0; i < numNodes; i++) {
+        graph.index[nodes[i].id] = i;
+    }
+
+    // Each station's k nearest are independent queries against the same grid
+    SpatialGrid grid(graph.nodes);
+    vector<vector<pair<double, int>>> nearest(numNodes);
+    parallelFor(0, numNodes, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            nearest[i] = grid.nearest(nodes[i].latitude, nodes[i].longitude, k, i);
+        }
+    });
+
+    // Symmetrize: j in kNN(i) connects both ways, and duplicates from mutual neighbors are dropped
+    vector<vector<pair<double, int>>> adjacency(numNodes);
+    for (int i = 0; i < numNodes; i++) {
+        for (const auto& edge : nearest[i]) {
+            adjacency[i].push_back(edge);
+            adjacency[edge.second].push_back({edge.first, i});
+        }
+        vector<pair<double, int>>().swap(nearest[i]);
+    }
+    size_t edgeSlots = 0;
+    double longest = 0.0;
+    for (int i = 0; i < numNodes; i++) {
+        auto& edges = adjacency[i];
+        sort(edges.begin(), edges.end(), [](const pair<double, int>& a, const pair<double, int>& b) {
+            return a.second < b.second;
+        });
+        edges.erase(unique(edges.begin(), edges.end(), [](const pair<double, int>& a, const pair<double, int>& b) {
+            return a.second == b.second;
+        }), edges.end());
+        edgeSlots += edges.size();
+        for (const auto& edge : edges) {
+            longest = max(longest, edge.first);
+        }
+    }
+    graph.maxRadius = longest;
+    flattenAdjacency(adjacency, edgeSlots, graph);
+    addCount("graph.edges_built", static_cast<long long>(edgeSlots / 2));
+}
+
+void buildGraph(const vector<Node>& nodes, const GraphOptions& options, StationGraph& graph) {
+    ScopedTimer timer("graph.build");
+    // Local indices follow the order stations are given in, so sort first for locality
+    vector<Node> ordered;
+    if (options.hilbertOrder) {
+        ordered = nodes;
+        sortByHilbertCurve(ordered);
+    }
+    const vector<Node>& input = options.hilbertOrder ? ordered : nodes;
+
+    if (options.mode == GraphMode::KNearest) {
+        buildKNearestGraph(input, options.k, graph);
+    } else {
+        buildGraph(input, options.maxRadius, graph);
+    }
+}
+
+const char* graphModeName(GraphMode mode) {
+    return mode == GraphMode::KNearest ? "k-nearest" : "threshold";
+}
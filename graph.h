@@ -0,0 +1,88 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_GRAPH_H
+#define EV_CHARGING_STATION_OPTIMIZATION_GRAPH_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+const double earthR = 6371.0;
+
+double haversine(double latitude, double longitude, double latitude_two, double longitude_two);
+
+// Struct to represent a station in the graph
+struct Node {
+    int id;
+    double latitude;
+    double longitude;
+    std::string stateOrProvince;
+    int multiplicity = 1;  // chargers collapsed into this site
+};
+
+// How buildGraph decides which stations are connected
+enum class GraphMode {
+    Threshold,  // every pair within maxRadius
+    KNearest    // each station to its k nearest stations, symmetrized
+};
+
+struct GraphOptions {
+    GraphMode mode = GraphMode::Threshold;
+    double maxRadius = 5.0;
+    int k = 8;
+    // Store stations in Hilbert curve order so neighbors sit close together in memory
+    bool hilbertOrder = true;
+};
+
+// Graph of one state's stations, built once up to maxRadius.
+// Every adjacency list is sorted by distance, so the graph for any
+// threshold <= maxRadius is a prefix of each list and needs no rebuild.
+// A threshold graph also takes new stations in place, without renumbering the others.
+struct StationGraph {
+    GraphMode mode = GraphMode::Threshold;
+    int k = 0;                           // neighbors per station in KNearest mode
+    double maxRadius = 0.0;              // longest edge that may be stored
+    std::vector<Node> nodes;             // local index -> station (nodes[u].id is the station id for output)
+    std::unordered_map<int, int> index;  // station id -> local index
+    std::vector<int> offsets;            // adjacency of u is [offsets[u], ends[u])
+    std::vector<int> ends;
+    std::vector<int> limits;             // u's edges have room up to limits[u], for insert
+    std::vector<int> targets;            // neighbor local index
+    std::vector<double> weights;         // edge length in km, ascending per node
+    unsigned long long generation = 0;   // changes on every clear, build or insert
+
+    int size() const { return static_cast<int>(nodes.size()); }
+    bool contains(int id) const { return index.find(id) != index.end(); }
+    // Local index of a station id, or -1 if it is not in the graph
+    int localIndex(int id) const;
+    const Node& station(int id) const { return nodes[index.at(id)]; }
+    // End of u's adjacency prefix for the given threshold
+    int prefixEnd(int u, double threshold) const;
+    int degree(int u, double threshold) const { return prefixEnd(u, threshold) - offsets[u]; }
+    long long edgeCount(double threshold) const;
+    void clear();
+    // Adds a station to a threshold graph as local index size(), connected to neighbors, the
+    // (distance km, local index) of every station within maxRadius of it. Only the new station's
+    // and its neighbors' adjacency lists are touched. Returns the new local index.
+    int insert(const Node& station, const std::vector<std::pair<double, int>>& neighbors);
+
+private:
+    // Adds the edge u -> v in order of length, moving u's list to the end when it has no room left
+    void addEdge(int u, int v, double distance);
+};
+
+// Labels each local index with its connected component (0, 1, ...) using only edges
+// of length <= threshold. Returns the number of components.
+int connectedComponents(const StationGraph& graph, double threshold, std::vector<int>& component);
+
+// Builds the graph with every pair of stations within maxRadius connected
+void buildGraph(const std::vector<Node>& nodes, double maxRadius, StationGraph& graph);
+
+// Builds the graph connecting each station to its k nearest stations (and they to it),
+// which bounds the degree in dense clusters and leaves no station isolated
+void buildKNearestGraph(const std::vector<Node>& nodes, int k, StationGraph& graph);
+
+// Builds the graph in the mode selected by options
+void buildGraph(const std::vector<Node>& nodes, const GraphOptions& options, StationGraph& graph);
+
+const char* graphModeName(GraphMode mode);
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_GRAPH_H
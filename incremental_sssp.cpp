@@ -0,0 +1,62 @@
+#include "incremental_sssp.h"
+#include "instrumentation.h"
+#include "shortest_paths.h"
+
+#include <limits>
+
+using namespace std;
+
+namespace {
+const double INF = numeric_limits<double>::infinity();
+}
+
+void IncrementalSearch::reset(const StationGraph& graph, int sourceId, double threshold) {
+    ScopedTimer timer("incremental.reset");
+    int n = graph.size();
+    this->threshold = threshold;
+    this->mode = graph.mode;
+    this->sourceId = sourceId;
+    generation = graph.generation;
+    stationIds.resize(n);
+    for (int u = 0; u < n; u++) {
+        stationIds[u] = graph.nodes[u].id;
+    }
+    dist.assign(n, INF);
+    dijkstra_distances(graph.localIndex(sourceId), graph, threshold, dist);
+}
+
+bool IncrementalSearch::matches(const StationGraph& graph, double threshold) const {
+    return sourceId != -1 && generation == graph.generation && this->threshold == threshold;
+}
+
+int IncrementalSearch::insert(const StationGraph& graph, int id) {
+    ScopedTimer timer("incremental.insert");
+    int v = graph.localIndex(id);
+    if (graph.mode == GraphMode::KNearest || mode == GraphMode::KNearest || v != static_cast<int>(dist.size()) ||
+        graph.size() != v + 1) {
+        reset(graph, sourceId, threshold);
+        int reached = 0;
+        for (double d : dist) {
+            reached += d < INF;
+        }
+        return reached;
+    }
+
+    generation = graph.generation;
+    dist.push_back(INF);
+    stationIds.push_back(id);
+    return static_cast<int>(dijkstra_decrease(v, graph, threshold, dist).size());
+}
+
+pair<int, double> IncrementalSearch::farthest() const {
+    // a sequential scan, far cheaper than the search it replaces
+    int farthestLocal = -1;
+    double maxDistance = 0.0;
+    for (int u = 0; u < static_cast<int>(dist.size()); u++) {
+        if (dist[u] > maxDistance && dist[u] < INF) {
+            maxDistance = dist[u];
+            farthestLocal = u;
+        }
+    }
+    return {farthestLocal == -1 ? -1 : stationIds[farthestLocal], maxDistance};
+}
@@ -0,0 +1,40 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_INCREMENTAL_SSSP_H
+#define EV_CHARGING_STATION_OPTIMIZATION_INCREMENTAL_SSSP_H
+
+#include <utility>
+#include <vector>
+
+#include "graph.h"
+
+// Shortest distances from one source kept up to date as stations are placed. Placing a station
+// in a threshold graph only adds edges, so distances can only drop and dijkstra_decrease fixes
+// them starting from the new station; the work is proportional to the region that got closer.
+class IncrementalSearch {
+public:
+    // Full Dijkstra from station sourceId
+    void reset(const StationGraph& graph, int sourceId, double threshold);
+
+    // Whether the distances are for this build of the graph, as StationGraph::generation tells,
+    // at this threshold
+    bool matches(const StationGraph& graph, double threshold) const;
+
+    // Updates the distances for station id, just added with StationGraph::insert to the graph they
+    // matched, and returns how many of them dropped; the other stations keep their local indices,
+    // so the distances only gain a slot. k-nearest graphs are rebuilt instead and can lose edges,
+    // so those are searched again from scratch and every reached station counts.
+    int insert(const StationGraph& graph, int id);
+
+    int source() const { return sourceId; }
+    // {farthest reachable station id, its distance in km}, or {-1, 0} like dijkstra_alg
+    std::pair<int, double> farthest() const;
+
+private:
+    double threshold = 0.0;
+    GraphMode mode = GraphMode::Threshold;
+    int sourceId = -1;
+    unsigned long long generation = 0;  // of the graph the distances are for
+    std::vector<int> stationIds;   // local index -> station id
+    std::vector<double> dist;      // by local index
+};
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_INCREMENTAL_SSSP_H
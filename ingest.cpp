@@ -0,0 +1,246 @@
+#include "ingest.h"
+#include "instrumentation.h"
+
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <algorithm>
+#include <unordered_map>
+#include <map>
+
+using namespace std;
+
+int collapseColocatedStations(vector<Node>& nodes, double epsilonKm) {
+    if (nodes.empty() || epsilonKm <= 0.0) {
+        return 0;
+    }
+    ScopedTimer timer("ingest.collapse");
+    const double kmPerDegree = earthR * M_PI / 180.0;
+    // Longitude is scaled for the highest latitude so cells are never narrower than epsilon
+    double maxAbsLat = 0.0;
+    for (const Node& node : nodes) {
+        maxAbsLat = max(maxAbsLat, fabs(node.latitude));
+    }
+    double kmPerLonDegree = kmPerDegree * cos(min(maxAbsLat, 89.0) * M_PI / 180.0);
+
+    auto cellKey = [](long long cx, long long cy) {
+        // shifted as unsigned: shifting a negative signed value is undefined
+        return static_cast<long long>((static_cast<unsigned long long>(cx) << 32) ^
+                                      (static_cast<unsigned long long>(cy) & 0xffffffffULL));
+    };
+
+    vector<Node> sites;
+    unordered_map<long long, vector<int>> cells;  // cell -> indices into sites
+    int merged = 0;
+    for (const Node& node : nodes) {
+        long long cx = static_cast<long long>(floor(node.longitude * kmPerLonDegree / epsilonKm));
+        long long cy = static_cast<long long>(floor(node.latitude * kmPerDegree / epsilonKm));
+
+        // anything within epsilon is in this cell or one of its eight neighbors
+        int match = -1;
+        for (long long dx = -1; dx <= 1 && match == -1; dx++) {
+            for (long long dy = -1; dy <= 1 && match == -1; dy++) {
+                auto it = cells.find(cellKey(cx + dx, cy + dy));
+                if (it == cells.end()) {
+                    continue;
+                }
+                for (int s : it->second) {
+                    const Node& site = sites[s];
+                    if (site.stateOrProvince == node.stateOrProvince &&
+                        haversine(site.latitude, site.longitude, node.latitude, node.longitude) <= epsilonKm) {
+                        match = s;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (match != -1) {
+            sites[match].multiplicity += node.multiplicity;
+            merged++;
+        } else {
+            cells[cellKey(cx, cy)].push_back(static_cast<int>(sites.size()));
+            sites.push_back(node);
+            sites.back().id = static_cast<int>(sites.size()) - 1;
+        }
+    }
+
+    nodes.swap(sites);
+    addCount("ingest.stations_merged", merged);
+    return merged;
+}
+
+//go through input and discard quoted sections
+vector<string> parseCSVLine(const string& line) {
+    vector<string> result;
+    bool inQuotes = false;
+    string field;
+    for (size_t i = 0; i < line.length(); ++i) {
+        char c = line[i];
+        if (c == '"') {
+            if (inQuotes && i + 1 < line.length() && line[i + 1] == '"') {
+                // Escaped quote
+                field += '"';
+                ++i;
+            } else {
+                inQuotes = !inQuotes;
+            }
+        } else if (c == ',' && !inQuotes) {
+            result.push_back(field);
+            field.clear();
+        } else {
+            field += c;
+        }
+    }
+    result.push_back(field);
+    return result;
+}
+
+const unordered_map<string, string>& stateAbbreviations() {
+    static const unordered_map<string, string> stateToAbbreviation = {
+            // Full names
+            {"ALABAMA", "AL"}, {"ALASKA", "AK"}, {"ARIZONA", "AZ"}, {"ARKANSAS", "AR"}, {"CALIFORNIA", "CA"},
+            {"COLORADO", "CO"}, {"CONNECTICUT", "CT"}, {"DELAWARE", "DE"}, {"FLORIDA", "FL"}, {"GEORGIA", "GA"},
+            {"HAWAII", "HI"}, {"IDAHO", "ID"}, {"ILLINOIS", "IL"}, {"INDIANA", "IN"}, {"IOWA", "IA"},
+            {"KANSAS", "KS"}, {"KENTUCKY", "KY"}, {"LOUISIANA", "LA"}, {"MAINE", "ME"}, {"MARYLAND", "MD"},
+            {"MASSACHUSETTS", "MA"}, {"MICHIGAN", "MI"}, {"MINNESOTA", "MN"}, {"MISSISSIPPI", "MS"}, {"MISSOURI", "MO"},
+            {"MONTANA", "MT"}, {"NEBRASKA", "NE"}, {"NEVADA", "NV"}, {"NEW HAMPSHIRE", "NH"}, {"NEW JERSEY", "NJ"},
+            {"NEW MEXICO", "NM"}, {"NEW YORK", "NY"}, {"NORTH CAROLINA", "NC"}, {"NORTH DAKOTA", "ND"},
+            {"OHIO", "OH"}, {"OKLAHOMA", "OK"}, {"OREGON", "OR"}, {"PENNSYLVANIA", "PA"}, {"RHODE ISLAND", "RI"},
+            {"SOUTH CAROLINA", "SC"}, {"SOUTH DAKOTA", "SD"}, {"TENNESSEE", "TN"}, {"TEXAS", "TX"}, {"UTAH", "UT"},
+            {"VERMONT", "VT"}, {"VIRGINIA", "VA"}, {"WASHINGTON", "WA"}, {"WEST VIRGINIA", "WV"}, {"WISCONSIN", "WI"},
+            {"WYOMING", "WY"},
+            // Abbreviations mapped to themselves for easier lookup
+            {"AL", "AL"}, {"AK", "AK"}, {"AZ", "AZ"}, {"AR", "AR"}, {"CA", "CA"}, {"CO", "CO"}, {"CT", "CT"},
+            {"DE", "DE"}, {"FL", "FL"}, {"GA", "GA"}, {"HI", "HI"}, {"ID", "ID"}, {"IL", "IL"}, {"IN", "IN"},
+            {"IA", "IA"}, {"KS", "KS"}, {"KY", "KY"}, {"LA", "LA"}, {"ME", "ME"}, {"MD", "MD"}, {"MA", "MA"},
+            {"MI", "MI"}, {"MN", "MN"}, {"MS", "MS"}, {"MO", "MO"}, {"MT", "MT"}, {"NE", "NE"}, {"NV", "NV"},
+            {"NH", "NH"}, {"NJ", "NJ"}, {"NM", "NM"}, {"NY", "NY"}, {"NC", "NC"}, {"ND", "ND"}, {"OH", "OH"},
+            {"OK", "OK"}, {"OR", "OR"}, {"PA", "PA"}, {"RI", "RI"}, {"SC", "SC"}, {"SD", "SD"}, {"TN", "TN"},
+            {"TX", "TX"}, {"UT", "UT"}, {"VT", "VT"}, {"VA", "VA"}, {"WA", "WA"}, {"WV", "WV"}, {"WI", "WI"},
+            {"WY", "WY"}
+    };
+    return stateToAbbreviation;
+}
+
+string stateAbbreviation(string state) {
+    transform(state.begin(), state.end(), state.begin(), ::toupper);
+    const unordered_map<string, string>& abbreviations = stateAbbreviations();
+    auto it = abbreviations.find(state);
+    return it == abbreviations.end() ? string() : it->second;
+}
+
+bool loadStations(const string& csvFile, vector<Node>& nodes) {
+    ScopedTimer timer("ingest.load_csv");
+    ifstream file(csvFile);
+    string line;
+
+
+    if (!file.is_open()) {
+        cerr << "Error: Could not open file " << csvFile << endl;
+        return false;
+    }
+
+    cerr << "File opened successfully!" << endl;
+
+    //skip header since its column headers
+    getline(file, line);
+
+    // ids continue from any stations already in nodes
+    int nodeId = nodes.size();
+    int firstNew = nodeId;
+    long long rowsParsed = 0;
+    long long rowsRejected = 0;
+    long long rowsOutsideUS = 0;
+    const unordered_map<string, string>& stateToAbbreviation = stateAbbreviations();
+
+    // process each section of data
+    //the sections sometimes will span multiple lines so process it until the section is finished
+    while (file) {
+        string section;
+        int quoteCount = 0;
+        bool sectionStarted = false;
+
+        // Read lines until a complete section is formed
+        while (getline(file, line)) {
+            if (sectionStarted) {
+                // Preserve newline character within quoted fields
+                section += "\n";
+            }
+            section += line;
+            sectionStarted = true;
+
+            // Count the number of double quotes in the current section
+            quoteCount = count(section.begin(), section.end(), '"');
+
+            // If quoteCount is even, we have a complete section
+            if (quoteCount % 2 == 0) {
+                break;
+            }
+        }
+
+        if (section.empty()) {
+            // End of file
+            break;
+        }
+
+        vector<string> row = parseCSVLine(section);
+        rowsParsed++;
+
+        // Handle incomplete rows
+        if (row.size() < 11) {
+            cerr << "Warning: Incomplete or malformed row with ID: " << row[0] << endl;
+            rowsRejected++;
+            continue;
+        }
+
+        if (!row[9].empty() && !row[10].empty()) {
+            // Convert Lat and Long to double
+            double latitude = stod(row[9]);
+            double longitude = stod(row[10]);
+
+            // Extract stateOrProvince and normalize to abbreviation
+            string stateOrProvince = row[6];
+            transform(stateOrProvince.begin(), stateOrProvince.end(), stateOrProvince.begin(), ::toupper);
+
+            if (stateToAbbreviation.find(stateOrProvince) != stateToAbbreviation.end()) {
+                stateOrProvince = stateToAbbreviation.at(stateOrProvince);
+            }
+
+            // Check if the stateOrProvince is a U.S. state
+            if (stateToAbbreviation.find(stateOrProvince) != stateToAbbreviation.end()) {
+                // Create a node and add it to the list
+                Node node;
+                node.id = nodeId++;
+                node.latitude = latitude;
+                node.longitude = longitude;
+                node.stateOrProvince = stateOrProvince;
+
+                nodes.push_back(node);
+            } else {
+                // Skip nodes not in the U.S.
+                rowsOutsideUS++;
+                continue;
+            }
+        } else {
+            cerr << "Warning: Missing latitude/longitude in row ID: " << row[0] << endl;
+            rowsRejected++;
+        }
+
+    }
+
+    file.close();
+    if (instrumentationEnabled()) {
+        recordCount("ingest.rows_parsed", rowsParsed);
+        recordCount("ingest.rows_rejected", rowsRejected);
+        recordCount("ingest.rows_outside_us", rowsOutsideUS);
+        map<string, long long> perState;
+        for (size_t i = firstNew; i < nodes.size(); i++) {
+            perState[nodes[i].stateOrProvince]++;
+        }
+        for (const auto& state : perState) {
+            recordCount("ingest.stations." + state.first, state.second);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,28 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_INGEST_H
+#define EV_CHARGING_STATION_OPTIMIZATION_INGEST_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "graph.h"
+
+// Splits one CSV record into fields; quoted fields may contain commas, newlines and "" escapes
+std::vector<std::string> parseCSVLine(const std::string& line);
+
+// Upper-case U.S. state names and abbreviations -> abbreviation
+const std::unordered_map<std::string, std::string>& stateAbbreviations();
+
+// Abbreviation for a state name or abbreviation in any case, or "" if it is not a U.S. state
+std::string stateAbbreviation(std::string state);
+
+// Appends every U.S. station in an Open Charge Map CSV export (state in column 6, latitude and
+// longitude in columns 9 and 10) to nodes. Returns false if the file cannot be opened.
+bool loadStations(const std::string& csvFile, std::vector<Node>& nodes);
+
+// Collapses stations of the same state that lie within epsilonKm of an earlier station into one
+// site, adding to that site's multiplicity. Uses a spatial hash with epsilon-sized cells, so it
+// runs in linear time. Ids are renumbered 0..n-1 in order. Returns how many stations were merged.
+int collapseColocatedStations(std::vector<Node>& nodes, double epsilonKm);
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_INGEST_H
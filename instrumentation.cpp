@@ -0,0 +1,94 @@
+#include "instrumentation.h"
+
+#include <map>
+#include <mutex>
+#include <iomanip>
+#include <algorithm>
+
+using namespace std;
+
+atomic<bool> instrumentationActive(false);
+
+namespace {
+struct PhaseTime {
+    long long calls = 0;
+    long long totalNs = 0;
+    long long maxNs = 0;
+};
+
+// Records come in once per phase or search, not per edge, so one lock is enough
+mutex recordsMutex;
+map<string, long long> counters;
+map<string, PhaseTime> phases;
+}
+
+void setInstrumentationEnabled(bool enabled) {
+    instrumentationActive.store(enabled, memory_order_relaxed);
+}
+
+void recordCount(const string& name, long long amount) {
+    lock_guard<mutex> lock(recordsMutex);
+    counters[name] += amount;
+}
+
+void recordTime(const char* phase, long long nanoseconds) {
+    lock_guard<mutex> lock(recordsMutex);
+    PhaseTime& time = phases[phase];
+    time.calls++;
+    time.totalNs += nanoseconds;
+    time.maxNs = max(time.maxNs, nanoseconds);
+}
+
+void printInstrumentation(ostream& out) {
+    lock_guard<mutex> lock(recordsMutex);
+    if (phases.empty() && counters.empty()) {
+        out << "Nothing recorded yet." << endl;
+        return;
+    }
+    ios::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+    out << fixed << setprecision(3);
+    if (!phases.empty()) {
+        out << left << setw(28) << "Phase" << right << setw(8) << "Calls" << setw(14) << "Total ms"
+            << setw(14) << "Mean ms" << setw(14) << "Max ms" << endl;
+        for (const auto& phase : phases) {
+            const PhaseTime& time = phase.second;
+            out << left << setw(28) << phase.first << right << setw(8) << time.calls
+                << setw(14) << time.totalNs / 1e6 << setw(14) << time.totalNs / 1e6 / time.calls
+                << setw(14) << time.maxNs / 1e6 << endl;
+        }
+    }
+    if (!counters.empty()) {
+        out << left << setw(28) << "Counter" << right << setw(16) << "Value" << endl;
+        for (const auto& counter : counters) {
+            out << left << setw(28) << counter.first << right << setw(16) << counter.second << endl;
+        }
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+void writeInstrumentationJSON(ostream& out) {
+    lock_guard<mutex> lock(recordsMutex);
+    // names are fixed identifiers and state codes, so they need no escaping
+    out << "{\n  \"phases\": {";
+    bool first = true;
+    for (const auto& phase : phases) {
+        out << (first ? "\n" : ",\n") << "    \"" << phase.first << "\": {\"calls\": " << phase.second.calls
+            << ", \"total_ns\": " << phase.second.totalNs << ", \"max_ns\": " << phase.second.maxNs << "}";
+        first = false;
+    }
+    out << (first ? "},\n" : "\n  },\n") << "  \"counters\": {";
+    first = true;
+    for (const auto& counter : counters) {
+        out << (first ? "\n" : ",\n") << "    \"" << counter.first << "\": " << counter.second;
+        first = false;
+    }
+    out << (first ? "}\n" : "\n  }\n") << "}\n";
+}
+
+void resetInstrumentation() {
+    lock_guard<mutex> lock(recordsMutex);
+    counters.clear();
+    phases.clear();
+}
@@ -0,0 +1,60 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_INSTRUMENTATION_H
+#define EV_CHARGING_STATION_OPTIMIZATION_INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <string>
+
+#include "trace.h"
+
+// Named counters and phase timers that show where a session's time and work go. Everything is
+// off by default; while off, a timer or counter costs one relaxed load of a flag, so they stay
+// in place in hot code. Searches count their work in locals and report it once at the end.
+
+extern std::atomic<bool> instrumentationActive;
+
+inline bool instrumentationEnabled() { return instrumentationActive.load(std::memory_order_relaxed); }
+void setInstrumentationEnabled(bool enabled);
+
+void recordCount(const std::string& name, long long amount);
+void recordTime(const char* phase, long long nanoseconds);
+
+inline void addCount(const char* name, long long amount = 1) {
+    if (instrumentationEnabled()) {
+        recordCount(name, amount);
+    }
+}
+
+// Adds the time from construction to destruction to the named phase, and traces it as an
+// event when tracing is on
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char* phase)
+            : phase(instrumentationEnabled() ? phase : nullptr), trace(phase) {
+        if (this->phase != nullptr) {
+            start = std::chrono::steady_clock::now();
+        }
+    }
+    ~ScopedTimer() {
+        if (phase != nullptr) {
+            auto end = std::chrono::steady_clock::now();
+            recordTime(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        }
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    const char* phase;
+    TraceScope trace;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Phases with their call count, total, mean and longest time, then counters, sorted by name
+void printInstrumentation(std::ostream& out);
+// The same as {"phases": {name: {calls, total_ns, max_ns}}, "counters": {name: value}}
+void writeInstrumentationJSON(std::ostream& out);
+void resetInstrumentation();
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_INSTRUMENTATION_H
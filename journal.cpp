@@ -0,0 +1,443 @@
+#include "journal.h"
+#include "ingest.h"
+#include "instrumentation.h"
+
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+const char SNAPSHOT_MAGIC[4] = {'E', 'V', 'S', 'T'};
+// 2 added station ids; a version 1 snapshot's stations are numbered in order
+const uint32_t SNAPSHOT_VERSION = 2;
+const char JOURNAL_HEADER[] = "# EV placement journal, generation ";
+// A journal with this many records is folded into the snapshot on the next start
+const int COMPACT_AFTER = 1000;
+
+// Identifies the data file a snapshot was made from
+struct Fingerprint {
+    int64_t size = -1;
+    int64_t modified = -1;
+};
+
+struct Snapshot {
+    uint64_t generation = 0;
+    Fingerprint data;
+    double epsilonKm = 0.0;
+    int32_t baseCount = 0;
+    vector<Node> nodes;
+};
+
+Fingerprint fingerprint(const string& path) {
+    Fingerprint result;
+    struct stat info;
+    if (stat(path.c_str(), &info) == 0) {
+        result.size = info.st_size;
+        result.modified = info.st_mtime;
+    }
+    return result;
+}
+
+// Writes the C stream's buffer and waits until it has reached the disk
+bool syncFile(FILE* file) {
+    if (fflush(file) != 0) {
+        return false;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Syncs the directory a file is in, so a rename or a new file in it survives a crash
+bool syncDirectory(const string& path) {
+#ifdef _WIN32
+    (void) path;  // there is no directory handle to sync here
+    return true;
+#else
+    size_t slash = path.rfind('/');
+    string directory = slash == string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int fd = open(directory.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+#endif
+}
+
+// Cuts a file back to size bytes
+bool truncateFile(FILE* file, long size) {
+#ifdef _WIN32
+    return _chsize(_fileno(file), size) == 0;
+#else
+    return ftruncate(fileno(file), size) == 0;
+#endif
+}
+
+template <typename T>
+void writeValue(FILE* file, const T& value) {
+    fwrite(&value, sizeof(T), 1, file);
+}
+
+template <typename T>
+bool readValue(ifstream& in, T& value) {
+    in.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return static_cast<bool>(in);
+}
+
+bool readSnapshot(const string& path, Snapshot& snapshot) {
+    ifstream in(path, ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    char magic[4];
+    uint32_t version;
+    int32_t count;
+    in.read(magic, sizeof(magic));
+    if (!in || memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0 || !readValue(in, version) ||
+        version < 1 || version > SNAPSHOT_VERSION || !readValue(in, snapshot.generation) || !readValue(in, snapshot.data.size) ||
+        !readValue(in, snapshot.data.modified) || !readValue(in, snapshot.epsilonKm) || !readValue(in, count) ||
+        !readValue(in, snapshot.baseCount) || count < 0 || snapshot.baseCount < 0 || snapshot.baseCount > count) {
+        return false;
+    }
+    // a corrupt count must not be allocated: each record takes at least its fixed fields
+    streamoff start = in.tellg();
+    in.seekg(0, ios::end);
+    streamoff remaining = in.tellg() - start;
+    in.seekg(start);
+    size_t recordBytes = (version >= 2 ? sizeof(int) : 0) + 2 * sizeof(double) + sizeof(int) + sizeof(uint8_t);
+    if (!in || remaining < static_cast<long long>(count) * static_cast<long long>(recordBytes)) {
+        return false;
+    }
+    snapshot.nodes.resize(count);
+    for (int i = 0; i < count; i++) {
+        Node& node = snapshot.nodes[i];
+        uint8_t length;
+        char state[256];
+        node.id = i;
+        if ((version >= 2 && !readValue(in, node.id)) || !readValue(in, node.latitude) || !readValue(in, node.longitude) || !readValue(in, node.multiplicity) ||
+            !readValue(in, length) || !in.read(state, length)) {
+            return false;
+        }
+        node.stateOrProvince.assign(state, length);
+    }
+    return true;
+}
+
+// Written beside the old snapshot and renamed over it, so a crash leaves one or the other whole
+bool writeSnapshot(const string& path, const Snapshot& snapshot) {
+    string temporary = path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    int32_t count = snapshot.nodes.size();
+    fwrite(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC), 1, file);
+    writeValue(file, SNAPSHOT_VERSION);
+    writeValue(file, snapshot.generation);
+    writeValue(file, snapshot.data.size);
+    writeValue(file, snapshot.data.modified);
+    writeValue(file, snapshot.epsilonKm);
+    writeValue(file, count);
+    writeValue(file, snapshot.baseCount);
+    for (const Node& node : snapshot.nodes) {
+        uint8_t length = static_cast<uint8_t>(min<size_t>(node.stateOrProvince.size(), 255));
+        writeValue(file, node.id);
+        writeValue(file, node.latitude);
+        writeValue(file, node.longitude);
+        writeValue(file, node.multiplicity);
+        writeValue(file, length);
+        fwrite(node.stateOrProvince.data(), 1, length, file);
+    }
+    bool written = !ferror(file) && syncFile(file);
+    written = fclose(file) == 0 && written;
+#ifdef _WIN32
+    remove(path.c_str());  // rename does not replace an existing file here
+#endif
+    return written && rename(temporary.c_str(), path.c_str()) == 0 && syncDirectory(path);
+}
+
+// FNV-1a, to tell a whole record from one cut short
+uint32_t checksum(const string& text) {
+    uint32_t hash = 2166136261u;
+    for (char c : text) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+// One journal record: "id,state,latitude,longitude,checksum" with the checksum in hex over the
+// text before its comma. Records written before ids were stored have no id and get -1. Returns
+// false for a line that isn't one.
+bool parseRecord(const string& line, Node& node) {
+    size_t comma = line.rfind(',');
+    char expected[16];
+    snprintf(expected, sizeof(expected), "%08x", comma == string::npos ? 0u : checksum(line.substr(0, comma)));
+    if (comma == string::npos || line.compare(comma + 1, string::npos, expected) != 0) {
+        return false;
+    }
+    vector<string> fields = parseCSVLine(line.substr(0, comma));
+    if (fields.size() == 3) {
+        fields.insert(fields.begin(), "-1");
+    }
+    if (fields.size() != 4 || fields[1].empty()) {
+        return false;
+    }
+    try {
+        size_t used0 = 0;
+        size_t used1 = 0;
+        size_t used2 = 0;
+        node.id = stoi(fields[0], &used0);
+        node.stateOrProvince = fields[1];
+        node.latitude = stod(fields[2], &used1);
+        node.longitude = stod(fields[3], &used2);
+        return used0 == fields[0].size() && used1 == fields[2].size() && used2 == fields[3].size();
+    } catch (const logic_error&) {
+        return false;
+    }
+}
+}
+
+PlacementJournal::PlacementJournal(const string& dataPath, int batchSize)
+        : dataPath(dataPath), journalFile(dataPath + ".journal"), snapshotFile(dataPath + ".stations"),
+          batchSize(max(1, batchSize)) {}
+
+PlacementJournal::~PlacementJournal() {
+    lock_guard<mutex> lock(journalMutex);
+    flushLocked();
+    if (journal != nullptr) {
+        fclose(journal);
+    }
+#ifndef _WIN32
+    if (lockFd != -1) {
+        close(lockFd);  // releases the lock
+    }
+#endif
+}
+
+bool PlacementJournal::lockJournal() {
+#ifdef _WIN32
+    return true;  // no flock; two processes on one data file are not guarded against here
+#else
+    if (lockFd == -1) {
+        lockFd = open(journalFile.c_str(), O_RDWR | O_CREAT, 0644);
+    }
+    // a lock on the file rather than on the journal's own stream, which compacting reopens
+    return lockFd != -1 && flock(lockFd, LOCK_EX | LOCK_NB) == 0;
+#endif
+}
+
+JournalLoad PlacementJournal::load(vector<Node>& nodes, double collapseEpsilonKm) {
+    ScopedTimer timer("journal.load");
+    JournalLoad result;
+    if (!lockJournal()) {
+        result.inUse = true;
+        return result;
+    }
+    epsilonKm = collapseEpsilonKm;
+    Snapshot snapshot;
+    bool haveSnapshot = readSnapshot(snapshotFile, snapshot);
+    Fingerprint data = fingerprint(dataPath);
+    // a snapshot stands in for the data file as long as the file has not changed (or is gone)
+    bool snapshotCurrent = haveSnapshot && snapshot.epsilonKm == collapseEpsilonKm &&
+                           (data.size == -1 || (snapshot.data.size == data.size &&
+                                                snapshot.data.modified == data.modified));
+    int snapshotPlaced = haveSnapshot ? snapshot.nodes.size() - snapshot.baseCount : 0;
+    // placed stations keep their ids, moved up or down only by a change in the data file's count
+    int shift = 0;
+    nodes.clear();
+    if (snapshotCurrent) {
+        nodes.swap(snapshot.nodes);
+        result.fromSnapshot = true;
+    } else {
+        if (!loadStations(dataPath, nodes)) {
+            return result;
+        }
+        result.rows = nodes.size();
+        result.merged = collapseColocatedStations(nodes, collapseEpsilonKm);
+        if (haveSnapshot) {
+            shift = static_cast<int>(nodes.size()) - snapshot.baseCount;
+        }
+        // stations placed on the old data file go on top of the new one
+        for (size_t i = snapshot.baseCount; i < snapshot.nodes.size(); i++) {
+            nodes.push_back(snapshot.nodes[i]);
+            nodes.back().id += shift;
+        }
+    }
+    result.loaded = true;
+    result.placed = snapshotPlaced;
+    result.nextId = 0;
+    for (const Node& node : nodes) {
+        result.nextId = max(result.nextId, node.id + 1);
+    }
+    generation = haveSnapshot ? snapshot.generation : 0;
+
+    // replay the journal, unless the snapshot already has it folded in
+    bool journalStale = false;
+    ifstream in(journalFile, ios::binary);
+    if (in.is_open()) {
+        stringstream contents;
+        contents << in.rdbuf();
+        string text = contents.str();
+        size_t headerLength = strlen(JOURNAL_HEADER);
+        unsigned long long journalGeneration = 0;
+        size_t start = text.find('\n');
+        bool valid = start != string::npos && text.compare(0, headerLength, JOURNAL_HEADER) == 0;
+        if (valid) {
+            try {
+                journalGeneration = stoull(text.substr(headerLength, start - headerLength));
+            } catch (const logic_error&) {
+                valid = false;
+            }
+        }
+        journalStale = !valid || journalGeneration < generation;
+        if (!journalStale) {
+            generation = journalGeneration;
+            size_t end;
+            // only whole lines; the last one may have been cut short by a crash
+            while ((end = text.find('\n', start + 1)) != string::npos) {
+                Node node;
+                if (parseRecord(text.substr(start + 1, end - start - 1), node)) {
+                    // replayed with the id it was placed with; one that would reuse an id (only
+                    // possible when the data file changed, or with no id stored) takes the next free one
+                    node.id = node.id == -1 ? result.nextId : max(node.id + shift, result.nextId);
+                    result.nextId = node.id + 1;
+                    nodes.push_back(node);
+                    result.placed++;
+                    result.replayed++;
+                }
+                start = end;
+            }
+        }
+    }
+    if (instrumentationEnabled()) {
+        addCount("journal.replayed", result.replayed);
+    }
+
+    if (!snapshotCurrent || journalStale || result.replayed >= COMPACT_AFTER) {
+        result.compacted = compact(nodes, result.placed);
+    }
+    if (!result.compacted) {
+        lock_guard<mutex> lock(journalMutex);
+        openJournal(false);
+    }
+    return result;
+}
+
+bool PlacementJournal::append(const Node& station) {
+    string record = to_string(station.id) + ",";
+    // the state is quoted like a CSV field, in case it is ever more than an abbreviation
+    record += station.stateOrProvince.find_first_of(",\"\n") == string::npos
+                      ? station.stateOrProvince
+                      : "\"" + station.stateOrProvince + "\"";
+    char numbers[64];
+    snprintf(numbers, sizeof(numbers), ",%.17g,%.17g", station.latitude, station.longitude);
+    record += numbers;
+    char sum[16];
+    snprintf(sum, sizeof(sum), ",%08x\n", checksum(record));
+    lock_guard<mutex> lock(journalMutex);
+    waiting += record;
+    waiting += sum;
+    if (++waitingCount >= batchSize) {
+        return flushLocked();
+    }
+    return true;
+}
+
+bool PlacementJournal::flush() {
+    lock_guard<mutex> lock(journalMutex);
+    return flushLocked();
+}
+
+bool PlacementJournal::flushLocked() {
+    if (waitingCount == 0) {
+        return true;
+    }
+    if (journal == nullptr) {
+        return false;
+    }
+    ScopedTimer timer("journal.flush");
+    fseek(journal, 0, SEEK_END);
+    long start = ftell(journal);
+    bool written = start >= 0 && fwrite(waiting.data(), 1, waiting.size(), journal) == waiting.size() &&
+                   syncFile(journal);
+    if (!written) {
+        // part of a batch would run into the retried records, or repeat them, so it goes
+        clearerr(journal);
+        if (start >= 0) {
+            truncateFile(journal, start);
+            fseek(journal, start, SEEK_SET);
+        }
+        return false;
+    }
+    if (instrumentationEnabled()) {
+        addCount("journal.records", waitingCount);
+        addCount("journal.syncs");
+    }
+    waiting.clear();
+    waitingCount = 0;
+    return true;
+}
+
+bool PlacementJournal::compact(const vector<Node>& nodes, int placedCount) {
+    ScopedTimer timer("journal.compact");
+    lock_guard<mutex> lock(journalMutex);
+    // records still waiting are part of nodes already, so they go into the snapshot instead
+    waiting.clear();
+    waitingCount = 0;
+    Snapshot snapshot;
+    snapshot.generation = generation + 1;
+    snapshot.data = fingerprint(dataPath);
+    snapshot.epsilonKm = epsilonKm;
+    snapshot.baseCount = nodes.size() - placedCount;
+    snapshot.nodes = nodes;
+    if (!writeSnapshot(snapshotFile, snapshot)) {
+        return false;
+    }
+    // from here the old journal is folded in; if the next step fails, the next start skips it
+    generation = snapshot.generation;
+    return openJournal(true);
+}
+
+bool PlacementJournal::openJournal(bool truncate) {
+    if (journal != nullptr) {
+        fclose(journal);
+    }
+    journal = fopen(journalFile.c_str(), truncate ? "wb" : "ab+");
+    if (journal == nullptr) {
+        return false;
+    }
+    // records are batched in waiting already; unbuffered, a failed write leaves nothing behind
+    // in the stream to be written later over a cut-off batch
+    setvbuf(journal, nullptr, _IONBF, 0);
+    fseek(journal, 0, SEEK_END);
+    long size = ftell(journal);
+    if (size <= 0) {
+        fprintf(journal, "%s%llu\n", JOURNAL_HEADER, generation);
+        return syncFile(journal) && syncDirectory(journalFile);
+    }
+    // a record cut short by a crash ends here, so the next one starts on a line of its own
+    fseek(journal, -1, SEEK_END);
+    int last = fgetc(journal);
+    fseek(journal, 0, SEEK_END);
+    if (last != '\n') {
+        fputc('\n', journal);
+    }
+    return true;
+}
@@ -0,0 +1,86 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_JOURNAL_H
+#define EV_CHARGING_STATION_OPTIMIZATION_JOURNAL_H
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "graph.h"
+
+// What PlacementJournal::load found
+struct JournalLoad {
+    bool loaded = false;        // false if neither the snapshot nor the data file could be read
+    bool fromSnapshot = false;  // the data file's stations came from the snapshot, not the CSV
+    int rows = 0;               // stations read from the CSV, before collapsing
+    int merged = 0;             // of those, collapsed into another site
+    int placed = 0;             // stations placed in earlier runs, at the end of the list
+    int replayed = 0;           // of those, read from the journal rather than the snapshot
+    int nextId = 0;             // one past the highest station id, for the next station placed
+    bool inUse = false;         // another process has the journal locked, so nothing was loaded
+    bool compacted = false;
+};
+
+// Stations placed in earlier runs, kept next to the data file so they are back on the next start.
+//
+// DATA.journal is append-only, one checksummed line per placed station, id included. Appends are
+// buffered and written with one fsync per batch, so a crash can lose the last unwritten batch but
+// never a written record; a line cut short by a crash fails its checksum and is skipped.
+// DATA.stations is a binary snapshot of every station: the data file's after collapsing, then the
+// placed ones.
+// Compacting writes a new snapshot with the journal folded in, syncs the directory so the rename
+// has reached the disk, and only then starts an empty journal. Both files carry a generation
+// number, so a crash between the two steps never applies a record twice.
+//
+// The journal is locked (flock, where there is one) from load until the object is destroyed, so a
+// menu program and a server started on the same data file can't both place stations with the
+// same ids; the second one finds it in use and loads nothing.
+class PlacementJournal {
+public:
+    explicit PlacementJournal(const std::string& dataPath, int batchSize = 8);
+    ~PlacementJournal();
+    PlacementJournal(const PlacementJournal&) = delete;
+    PlacementJournal& operator=(const PlacementJournal&) = delete;
+
+    // Fills nodes with every station, the placed ones last. The data file's stations are numbered
+    // 0..n-1 and come from the snapshot if it was made from the file as it is now, or else from
+    // the CSV, collapsed within collapseEpsilonKm; placed stations from the snapshot and then the
+    // journal go on top with the ids they were placed with. Compacts when the snapshot was missing
+    // or out of date, or the journal is long, so the next start is quick. Opens the journal for
+    // appending.
+    JournalLoad load(std::vector<Node>& nodes, double collapseEpsilonKm);
+
+    // Adds a placed station, id included; written once batchSize are waiting. Safe to call from
+    // several threads, though stations should be appended in the order of their ids. Returns false
+    // if the batch it completed could not be written.
+    bool append(const Node& station);
+    // Writes and syncs whatever is waiting. Returns false if the journal could not be written; the
+    // records then stay waiting, with any part of them that did reach the file cut off again, and
+    // the next flush tries them again.
+    bool flush();
+    // Writes nodes, the last placedCount of them placed, as the new snapshot and empties the journal
+    bool compact(const std::vector<Node>& nodes, int placedCount);
+
+    const std::string& journalPath() const { return journalFile; }
+    const std::string& snapshotPath() const { return snapshotFile; }
+
+private:
+    std::string dataPath;
+    std::string journalFile;
+    std::string snapshotFile;
+    int batchSize;
+    double epsilonKm = 0.0;
+    unsigned long long generation = 0;  // of the journal being appended to
+    std::mutex journalMutex;            // guards everything below
+    std::FILE* journal = nullptr;
+    std::string waiting;                // records not yet written
+    int waitingCount = 0;
+    int lockFd = -1;                    // holds the lock on the journal file
+
+    bool flushLocked();
+    bool openJournal(bool truncate);
+    // Takes the lock for this process; false if another one has it
+    bool lockJournal();
+};
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_JOURNAL_H
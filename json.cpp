@@ -0,0 +1,205 @@
+#include "json.h"
+
+#include <cstdio>
+#include <cctype>
+#include <stdexcept>
+
+using namespace std;
+
+string jsonQuote(const string& text) {
+    string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (c == '\n') {
+            quoted += "\\n";
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            quoted += escaped;
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+namespace {
+void skipSpace(const string& text, size_t& pos) {
+    while (pos < text.size() && isspace(static_cast<unsigned char>(text[pos]))) {
+        pos++;
+    }
+}
+
+// Reads the string literal starting at pos, unescaped, and moves pos past it
+bool readString(const string& text, size_t& pos, string& value) {
+    if (pos >= text.size() || text[pos] != '"') {
+        return false;
+    }
+    value.clear();
+    for (pos++; pos < text.size(); pos++) {
+        char c = text[pos];
+        if (c == '"') {
+            pos++;
+            return true;
+        }
+        if (c != '\\') {
+            value += c;
+            continue;
+        }
+        if (++pos >= text.size()) {
+            return false;
+        }
+        switch (text[pos]) {
+            case 'n': value += '\n'; break;
+            case 't': value += '\t'; break;
+            case 'r': value += '\r'; break;
+            case 'b': value += '\b'; break;
+            case 'f': value += '\f'; break;
+            case 'u': {
+                if (pos + 4 >= text.size()) {
+                    return false;
+                }
+                unsigned int code = stoul(text.substr(pos + 1, 4), nullptr, 16);
+                pos += 4;
+                // UTF-8; surrogate pairs are not combined
+                if (code < 0x80) {
+                    value += static_cast<char>(code);
+                } else if (code < 0x800) {
+                    value += static_cast<char>(0xC0 | (code >> 6));
+                    value += static_cast<char>(0x80 | (code & 0x3F));
+                } else {
+                    value += static_cast<char>(0xE0 | (code >> 12));
+                    value += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    value += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: value += text[pos]; break;
+        }
+    }
+    return false;
+}
+
+size_t skipDigits(const string& text, size_t pos) {
+    while (pos < text.size() && isdigit(static_cast<unsigned char>(text[pos]))) {
+        pos++;
+    }
+    return pos;
+}
+
+// true, false, null, or a number as JSON writes it: no leading zeros, +, hex, inf or nan
+bool isLiteral(const string& value) {
+    if (value == "true" || value == "false" || value == "null") {
+        return true;
+    }
+    size_t pos = value.compare(0, 1, "-") == 0 ? 1 : 0;
+    size_t digits = skipDigits(value, pos);
+    if (digits == pos || (value[pos] == '0' && digits > pos + 1)) {
+        return false;
+    }
+    pos = digits;
+    if (pos < value.size() && value[pos] == '.') {
+        digits = skipDigits(value, pos + 1);
+        if (digits == pos + 1) {
+            return false;
+        }
+        pos = digits;
+    }
+    if (pos < value.size() && (value[pos] == 'e' || value[pos] == 'E')) {
+        pos++;
+        if (pos < value.size() && (value[pos] == '+' || value[pos] == '-')) {
+            pos++;
+        }
+        digits = skipDigits(value, pos);
+        if (digits == pos) {
+            return false;
+        }
+        pos = digits;
+    }
+    return pos == value.size();
+}
+}
+
+bool parseFlatObject(const string& text, map<string, string>& fields, string& error, set<string>* quoted) {
+    size_t pos = 0;
+    skipSpace(text, pos);
+    if (pos >= text.size() || text[pos] != '{') {
+        error = "expected a JSON object";
+        return false;
+    }
+    pos++;
+    skipSpace(text, pos);
+    bool first = true;
+    while (pos < text.size() && text[pos] != '}') {
+        if (!first) {
+            if (text[pos] != ',') {
+                error = "expected , between fields";
+                return false;
+            }
+            pos++;
+            skipSpace(text, pos);
+        }
+        first = false;
+        string key;
+        string value;
+        bool isString = false;
+        try {
+            if (!readString(text, pos, key)) {
+                error = "expected a quoted field name";
+                return false;
+            }
+            skipSpace(text, pos);
+            if (pos >= text.size() || text[pos] != ':') {
+                error = "expected : after " + key;
+                return false;
+            }
+            pos++;
+            skipSpace(text, pos);
+            if (pos < text.size() && text[pos] == '"') {
+                if (!readString(text, pos, value)) {
+                    error = "unterminated string in " + key;
+                    return false;
+                }
+                isString = true;
+            } else {
+                // a number, true, false or null, kept as written
+                size_t end = pos;
+                while (end < text.size() && text[end] != ',' && text[end] != '}' &&
+                       !isspace(static_cast<unsigned char>(text[end]))) {
+                    end++;
+                }
+                value = text.substr(pos, end - pos);
+                if (!isLiteral(value)) {
+                    error = "only strings, numbers, true, false and null are accepted, in " + key;
+                    return false;
+                }
+                pos = end;
+            }
+        } catch (const logic_error&) {
+            error = "bad \\u escape";
+            return false;
+        }
+        fields[key] = value;
+        if (quoted != nullptr) {
+            if (isString) {
+                quoted->insert(key);
+            } else {
+                quoted->erase(key);
+            }
+        }
+        skipSpace(text, pos);
+    }
+    if (pos >= text.size()) {
+        error = "unterminated object";
+        return false;
+    }
+    pos++;
+    skipSpace(text, pos);
+    if (pos != text.size()) {
+        error = "unexpected text after the object";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,18 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_JSON_H
+#define EV_CHARGING_STATION_OPTIMIZATION_JSON_H
+
+#include <string>
+#include <map>
+#include <set>
+
+// text as a JSON string literal, quotes included
+std::string jsonQuote(const std::string& text);
+
+// Parses a JSON object whose values are all strings, numbers, true, false or null, such as one
+// request line sent to the server. String values are unescaped and the rest kept as written;
+// quoted, if given, gets the keys whose values were strings. Returns false and sets error for
+// anything else, including bare values that are not JSON numbers.
+bool parseFlatObject(const std::string& text, std::map<std::string, std::string>& fields, std::string& error,
+                     std::set<std::string>* quoted = nullptr);
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_JSON_H
@@ -0,0 +1,289 @@
+#include "landmarks.h"
+#include "instrumentation.h"
+#include "shortest_paths.h"
+#include "search_workspace.h"
+
+#include <queue>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+const double INF = numeric_limits<double>::infinity();
+typedef priority_queue<pair<double, int>, vector<pair<double, int>>, greater<>> MinQueue;
+}
+
+void LandmarkOracle::build(const StationGraph& graph, double threshold, int perComponent) {
+    ScopedTimer timer("landmarks.build");
+    int n = graph.size();
+    this->threshold = threshold;
+    this->mode = graph.mode;
+    this->perComponent = perComponent;
+    stationIds.resize(n);
+    index.clear();
+    for (int u = 0; u < n; u++) {
+        stationIds[u] = graph.nodes[u].id;
+        index[stationIds[u]] = u;
+    }
+    int count = connectedComponents(graph, threshold, component);
+    vector<int> first(count, -1);
+    for (int u = n - 1; u >= 0; u--) {
+        first[component[u]] = u;
+    }
+    landmarks.assign(static_cast<size_t>(count) * perComponent, -1);
+    distances.assign(static_cast<size_t>(n) * perComponent, INF);
+
+    // scratch is reset after every search by walking only the nodes it reached
+    vector<double> dist(n, INF);
+    vector<double> closest(n, INF);  // distance to the nearest landmark picked so far
+    for (int c = 0; c < count; c++) {
+        // The first landmark is the station farthest from an arbitrary one, then each next
+        // landmark is the station farthest from all landmarks picked so far
+        vector<int> members = dijkstra_distances(first[c], graph, threshold, dist);
+        int next = members.back();
+        for (int v : members) {
+            dist[v] = INF;
+        }
+        for (int j = 0; j < perComponent; j++) {
+            landmarks[c * perComponent + j] = graph.nodes[next].id;
+            dijkstra_distances(next, graph, threshold, dist);
+            for (int v : members) {
+                distances[static_cast<size_t>(v) * perComponent + j] = dist[v];
+                closest[v] = min(closest[v], dist[v]);
+                dist[v] = INF;
+            }
+            int farthest = next;
+            for (int v : members) {
+                if (closest[v] > closest[farthest]) {
+                    farthest = v;
+                }
+            }
+            if (closest[farthest] == 0.0) {
+                break;  // every station in the component is already a landmark
+            }
+            next = farthest;
+        }
+    }
+}
+
+bool LandmarkOracle::matches(const StationGraph& graph, double threshold) const {
+    if (empty() || this->threshold != threshold || mode != graph.mode ||
+        static_cast<int>(stationIds.size()) != graph.size()) {
+        return false;
+    }
+    for (int u = 0; u < graph.size(); u++) {
+        if (graph.nodes[u].id != stationIds[u]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void LandmarkOracle::propagate(const StationGraph& graph, int j, int source) {
+    int k = perComponent;
+    double best = INF;
+    int end = graph.prefixEnd(source, threshold);
+    for (int e = graph.offsets[source]; e < end; e++) {
+        best = min(best, distances[static_cast<size_t>(graph.targets[e]) * k + j] + graph.weights[e]);
+    }
+    if (!(best < distances[static_cast<size_t>(source) * k + j])) {
+        return;
+    }
+    // Only routes through the new station got shorter, so the search stops wherever they don't
+    distances[static_cast<size_t>(source) * k + j] = best;
+    MinQueue pq;
+    pq.push({best, source});
+    while (!pq.empty()) {
+        pair<double, int> top = pq.top();
+        pq.pop();
+        int u = top.second;
+        if (top.first > distances[static_cast<size_t>(u) * k + j]) {
+            continue;
+        }
+        end = graph.prefixEnd(u, threshold);
+        for (int e = graph.offsets[u]; e < end; e++) {
+            int v = graph.targets[e];
+            double newDist = top.first + graph.weights[e];
+            if (newDist < distances[static_cast<size_t>(v) * k + j]) {
+                distances[static_cast<size_t>(v) * k + j] = newDist;
+                pq.push({newDist, v});
+            }
+        }
+    }
+}
+
+void LandmarkOracle::addStation(const StationGraph& graph, int id) {
+    ScopedTimer timer("landmarks.add_station");
+    int v = graph.localIndex(id);
+    if (graph.mode == GraphMode::KNearest || mode == GraphMode::KNearest || v == -1) {
+        build(graph, threshold, perComponent);
+        return;
+    }
+
+    // The rebuilt graph has its own local order, so move every row to its new position
+    int n = graph.size();
+    int k = perComponent;
+    vector<int> newComponent(n, -1);
+    vector<double> newDistances(static_cast<size_t>(n) * k, INF);
+    for (int u = 0; u < n; u++) {
+        auto it = index.find(graph.nodes[u].id);
+        if (it == index.end()) {
+            continue;
+        }
+        newComponent[u] = component[it->second];
+        copy(distances.begin() + static_cast<size_t>(it->second) * k,
+             distances.begin() + static_cast<size_t>(it->second + 1) * k,
+             newDistances.begin() + static_cast<size_t>(u) * k);
+    }
+    component.swap(newComponent);
+    distances.swap(newDistances);
+    stationIds.resize(n);
+    index.clear();
+    for (int u = 0; u < n; u++) {
+        stationIds[u] = graph.nodes[u].id;
+        index[stationIds[u]] = u;
+    }
+
+    vector<int> joined;
+    int end = graph.prefixEnd(v, threshold);
+    for (int e = graph.offsets[v]; e < end; e++) {
+        int c = component[graph.targets[e]];
+        if (c != -1 && find(joined.begin(), joined.end(), c) == joined.end()) {
+            joined.push_back(c);
+        }
+    }
+    if (joined.empty()) {
+        // An isolated station is its own component and landmark
+        component[v] = static_cast<int>(landmarks.size()) / k;
+        landmarks.push_back(id);
+        landmarks.resize(landmarks.size() + k - 1, -1);
+        distances[static_cast<size_t>(v) * k] = 0.0;
+        return;
+    }
+
+    // Stations bridged into one component keep the largest one's landmarks, and everyone
+    // from the smaller ones starts over at infinity from them
+    int target = joined[0];
+    if (joined.size() > 1) {
+        vector<int> sizes(landmarks.size() / k, 0);
+        for (int u = 0; u < n; u++) {
+            if (component[u] != -1) {
+                sizes[component[u]]++;
+            }
+        }
+        for (int c : joined) {
+            if (sizes[c] > sizes[target]) {
+                target = c;
+            }
+        }
+        for (int u = 0; u < n; u++) {
+            int c = component[u];
+            if (c != -1 && c != target && find(joined.begin(), joined.end(), c) != joined.end()) {
+                component[u] = target;
+                fill(distances.begin() + static_cast<size_t>(u) * k,
+                     distances.begin() + static_cast<size_t>(u + 1) * k, INF);
+            }
+        }
+        for (int c : joined) {
+            if (c != target) {
+                fill(landmarks.begin() + c * k, landmarks.begin() + (c + 1) * k, -1);
+            }
+        }
+    }
+    component[v] = target;
+    for (int j = 0; j < k; j++) {
+        if (landmarks[target * k + j] != -1) {
+            propagate(graph, j, v);
+        }
+    }
+}
+
+double LandmarkOracle::lowerBound(int u, int v) const {
+    const double* a = &distances[static_cast<size_t>(u) * perComponent];
+    const double* b = &distances[static_cast<size_t>(v) * perComponent];
+    const int* used = &landmarks[component[u] * perComponent];
+    double lower = 0.0;
+    for (int j = 0; j < perComponent && used[j] != -1; j++) {
+        lower = max(lower, fabs(a[j] - b[j]));
+    }
+    return lower;
+}
+
+DistanceBounds LandmarkOracle::bounds(int fromId, int toId) const {
+    auto from = index.find(fromId);
+    auto to = index.find(toId);
+    if (from == index.end() || to == index.end() || component[from->second] != component[to->second]) {
+        return {INF, INF};
+    }
+    int s = from->second;
+    int t = to->second;
+    const double* a = &distances[static_cast<size_t>(s) * perComponent];
+    const double* b = &distances[static_cast<size_t>(t) * perComponent];
+    const int* used = &landmarks[component[s] * perComponent];
+    double upper = INF;
+    for (int j = 0; j < perComponent && used[j] != -1; j++) {
+        upper = min(upper, a[j] + b[j]);
+    }
+    return {lowerBound(s, t), upper};
+}
+
+Route LandmarkOracle::route(const StationGraph& graph, int fromId, int toId) const {
+    ScopedTimer timer("route.landmarks");
+    Route route;
+    auto from = index.find(fromId);
+    auto to = index.find(toId);
+    if (from == index.end() || to == index.end() || component[from->second] != component[to->second]) {
+        return route;
+    }
+    int s = from->second;
+    int t = to->second;
+    const Node& goal = graph.nodes[t];
+    // Both bounds are consistent, so their maximum is too and every node settles once
+    auto potential = [&](int v) {
+        const Node& node = graph.nodes[v];
+        return max(haversine(node.latitude, node.longitude, goal.latitude, goal.longitude), lowerBound(v, t));
+    };
+
+    SearchWorkspace& search = localWorkspace();
+    search.begin(graph.size());
+    search.setDistance(s, 0.0);
+    search.push(potential(s), s);
+    while (!search.heapEmpty()) {
+        int u = search.pop().second;
+        if (search.visited(u)) {
+            continue;
+        }
+        search.markVisited(u);
+        route.settled++;
+        if (u == t) {
+            break;
+        }
+        double du = search.distance(u);
+        int end = graph.prefixEnd(u, threshold);
+        for (int e = graph.offsets[u]; e < end; e++) {
+            int v = graph.targets[e];
+            double newDist = du + graph.weights[e];
+            if (newDist < search.distance(v)) {
+                search.setDistance(v, newDist, u);
+                search.push(newDist + potential(v), v);
+            }
+        }
+    }
+
+    if (!search.visited(t)) {
+        return route;
+    }
+    route.found = true;
+    route.distance = search.distance(t);
+    for (int v = t; v != -1; v = search.parent(v)) {
+        route.path.push_back(graph.nodes[v].id);
+    }
+    reverse(route.path.begin(), route.path.end());
+    return route;
+}
+
+int LandmarkOracle::landmarkCount() const {
+    return static_cast<int>(count_if(landmarks.begin(), landmarks.end(), [](int id) { return id != -1; }));
+}
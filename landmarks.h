@@ -0,0 +1,58 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_LANDMARKS_H
+#define EV_CHARGING_STATION_OPTIMIZATION_LANDMARKS_H
+
+#include <vector>
+#include <unordered_map>
+
+#include "graph.h"
+#include "route.h"
+
+// Lower and upper bounds on the route distance between two stations, in km
+struct DistanceBounds {
+    double lower;
+    double upper;
+};
+
+// ALT (A*, landmarks, triangle inequality) oracle. A few landmarks are picked in every
+// connected component and the route distance from each of them to every station is stored.
+// For any landmark L, |d(L, s) - d(L, t)| <= d(s, t) <= d(L, s) + d(L, t), which bounds a
+// query in O(k) and gives A* a much tighter potential than straight-line distance.
+class LandmarkOracle {
+public:
+    // Picks up to perComponent landmarks in each component by farthest-point selection
+    void build(const StationGraph& graph, double threshold, int perComponent = 4);
+
+    // Whether the tables were built for exactly the graph's stations, in its order, at this threshold
+    bool matches(const StationGraph& graph, double threshold) const;
+
+    // Updates the tables for a station just inserted into the graph. A new station in a
+    // threshold graph only adds edges, so distances can only shrink and are propagated from it;
+    // in a k-nearest graph it can also remove edges, so the tables are rebuilt.
+    void addStation(const StationGraph& graph, int id);
+
+    // O(k) bounds; both are infinity when the stations are not connected
+    DistanceBounds bounds(int fromId, int toId) const;
+
+    // A* with the larger of the landmark and straight-line bounds as its potential
+    Route route(const StationGraph& graph, int fromId, int toId) const;
+
+    bool empty() const { return stationIds.empty(); }
+    int landmarkCount() const;
+
+private:
+    double threshold = 0.0;
+    GraphMode mode = GraphMode::Threshold;
+    int perComponent = 0;
+    // Rows follow the graph's local indices, so A* reads them without a lookup
+    std::vector<int> stationIds;          // local index -> station id
+    std::unordered_map<int, int> index;   // station id -> local index
+    std::vector<int> component;           // local index -> component
+    std::vector<int> landmarks;           // component * perComponent + j -> landmark station id, or -1
+    std::vector<double> distances;        // u * perComponent + j -> km from u's component's landmark j
+
+    double lowerBound(int u, int v) const;
+    // Decrease-only Dijkstra for landmark slot j through a newly inserted node
+    void propagate(const StationGraph& graph, int j, int source);
+};
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_LANDMARKS_H
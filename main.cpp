@@ -7,419 +7,383 @@
 #include <unordered_map>
 #include <algorithm>
 #include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "graph.h"
+#include "ingest.h"
+#include "shortest_paths.h"
+#include "diameter.h"
+#include "eccentricity.h"
+#include "batched_sssp.h"
+#include "route.h"
+#include "contraction_hierarchy.h"
+#include "landmarks.h"
+#include "placement.h"
+#include "instrumentation.h"
+#include "trace.h"
+#include "batch.h"
+#include "server.h"
+#include "journal.h"
+#include "parallel.h"
 
 using namespace std;
 
-const double earthR = 6371.0;
-
-double haversine(double latitude, double longitude, double latitude_two, double longitude_two) {
-    const double DEG_TO_RAD = M_PI / 180.0;
-    latitude *= DEG_TO_RAD;
-    longitude *= DEG_TO_RAD;
-    latitude_two *= DEG_TO_RAD;
-    longitude_two *= DEG_TO_RAD;
-    double dlat = latitude_two - latitude;
-    double dlon = longitude_two - longitude;
-    double a = sin(dlat / 2) * sin(dlat / 2) +
-               cos(latitude) * cos(latitude_two) *
-               sin(dlon / 2) * sin(dlon / 2);
-    double c = 2 * atan2(sqrt(a), sqrt(1 - a));
-    double distance = earthR * c;
-    return distance;
-}
+// Signature shared by the single-source searches in shortest_paths.h
+typedef pair<int, double> (*SearchFunction)(int, const StationGraph&, double);
 
-// Struct to represent a node in the graph
-struct Node {
-    int id;
-    double latitude;
-    double longitude;
-    string stateOrProvince;
-    vector<pair<int, double>> neighbors;
-};
-
-// Function to build the graph
-void buildGraph(const vector<Node>& nodes, double thresholdDistance, unordered_map<int, Node>& graph) {
-    int numNodes = nodes.size();
-    int edgeCount = 0;
-    cout << "Building graph... (threshold: " << thresholdDistance << " km)" << endl;
-
-    for (int i = 0; i < numNodes; i++) {
-        Node node = nodes[i];
-        for (int j = i + 1; j < numNodes; j++) {
-            Node otherNode = nodes[j];
-            double distance = haversine(node.latitude, node.longitude, otherNode.latitude, otherNode.longitude);
-            if (distance <= thresholdDistance) {
-                graph[node.id].neighbors.push_back({otherNode.id, distance});
-                graph[otherNode.id].neighbors.push_back({node.id, distance});
-                edgeCount++;
-            }
-        }
-    }
-}
-//go through input and discard quoted sections
-vector<string> parseCSVLine(const string& line) {
-    vector<string> result;
-    bool inQuotes = false;
-    string field;
-    for (size_t i = 0; i < line.length(); ++i) {
-        char c = line[i];
-        if (c == '"') {
-            if (inQuotes && i + 1 < line.length() && line[i + 1] == '"') {
-                // Escaped quote
-                field += '"';
-                ++i;
-            } else {
-                inQuotes = !inQuotes;
-            }
-        } else if (c == ',' && !inQuotes) {
-            result.push_back(field);
-            field.clear();
-        } else {
-            field += c;
-        }
+// The library builds graphs without a word, since batch and server jobs build them on pool
+// threads; the menu says what it is building before it starts
+void printBuilding(const GraphOptions& options) {
+    if (options.mode == GraphMode::KNearest) {
+        cout << "Building graph... (" << options.k << " nearest neighbors)" << endl;
+    } else {
+        cout << "Building graph... (max radius: " << options.maxRadius << " km)" << endl;
     }
-    result.push_back(field);
-    return result;
 }
 
-//Djikstr'a Alg
-pair<int, double> dijkstra_alg(int Id, const unordered_map<int, Node>& graph) {
-    unordered_map<int, double> dist;
-    vector<int> Ids;
-    for (auto it = graph.begin(); it != graph.end(); ++it) {
-        int node = it->first;
-        Ids.push_back(node);
-        dist[node] = numeric_limits<double>::infinity();
-    }
-    dist[Id] = 0.0;
-    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<>> pq;
-    pq.push({0.0, Id});
-    while (!pq.empty()) {
-        pair<double, int> top = pq.top();
-        double currDist = top.first;
-        int currNode = top.second;
-        pq.pop();
-        if (!(currDist > dist[currNode])) {
-            const auto& neighbors = graph.at(currNode).neighbors;
-            for (int i = 0; i < static_cast<int>(neighbors.size()); ++i) {
-                int neighbor = neighbors[i].first;
-                double weight = neighbors[i].second;
-                double newDist = currDist + weight;
-
-                if (newDist < dist[neighbor]) {
-                    dist[neighbor] = newDist;
-                    pq.push({newDist, neighbor});
-                }
-            }
-        }
+// Source for the farthest-node searches, the same one the next placement starts from: the
+// station placed last in this state, or else the lowest station id with an edge. Returns -1 if
+// there is none.
+int chooseSource(const PlacementSession& session) {
+    if (session.currentGraph().size() == 0) {
+        cout << "No nodes." << endl;
+        return -1;
     }
-    int farthestNodeId = -1;
-    double maxDistance = 0.0;
-    for (int i = 0; i < static_cast<int>(Ids.size()); ++i) {
-        int nodeId = Ids[i];
-        double distance = dist[nodeId];
-        if (distance > maxDistance && distance < numeric_limits<double>::infinity()) {
-            maxDistance = distance;
-            farthestNodeId = nodeId;
-        }
+    int sourceId = session.nextSource();
+    if (sourceId == -1) {
+        cout << "No suitable source." << endl;
+        return -1;
     }
-
-    return {farthestNodeId, maxDistance};
+    cout << "Using source node: " << sourceId << endl;
+    return sourceId;
 }
 
-pair<int, double> bellman_ford(int ID, const unordered_map<int, Node>& graph) {
-    unordered_map<int, double> distanceMap;
-    vector<int> nodeIDs;
+// Prints a search's farthest node. Returns {source id, farthest id}, or {-1, -1} if there is none.
+vector<int> reportFarthest(int sourceId, const pair<int, double>& result) {
+    if (result.first != -1) {
+        cout << "The farthest node from node " << sourceId
+             << " is node " << result.first
+             << " with a distance of " << result.second << " km." << endl;
 
-    // Initialize distances to all nodes as infinity and collect node IDs
-    for (auto it = graph.begin(); it != graph.end(); ++it) {
-        int nodeID = it->first;
-        nodeIDs.push_back(nodeID);
-        distanceMap[nodeID] = numeric_limits<double>::infinity();
-    }
-    distanceMap[ID] = 0.0;
-
-    int size = graph.size();
-
-    for (int i = 0; i < size - 1; i++) {
-        bool updated = false;
-        for (auto it = graph.begin();it!= graph.end(); it++) {
-            int currentNode= it->first;
-            vector<pair<int, double>> neighbors= it->second.neighbors;
-            for (auto neighbor = neighbors.begin(); neighbor != neighbors.end(); neighbor++) {
-                int neighborID = neighbor->first;
-                double edgeWeight = neighbor->second;
-                if (distanceMap[currentNode] != numeric_limits<double>::infinity() && distanceMap[currentNode] + edgeWeight < distanceMap[neighborID]) {
-                    distanceMap[neighborID] = distanceMap[currentNode] + edgeWeight;
-                    updated = true;
-                }
-            }
-        }
-        if (!updated) {
-            break;
-        }
+        return {sourceId, result.first};
+    } else {
+        cout << "No reachable nodes found from the source node." << endl;
+        return {-1, -1};
     }
+}
 
-    // Find the farthest node from the source
-    int farthestNodeID = -1;
-    double maxDistance = 0.0;
-    for (auto it = nodeIDs.begin(); it != nodeIDs.end(); ++it) {
-        int nodeID = *it;
-        double distance = distanceMap[nodeID];
-        if (distance > maxDistance && distance != numeric_limits<double>::infinity()) {
-            maxDistance = distance;
-            farthestNodeID = nodeID;
-        }
+// Picks the source node, times one search from it and prints the farthest node.
+// Returns {source id, farthest id}, or {-1, -1} if there is no result.
+vector<int> runSearch(const string& name, SearchFunction search, const PlacementSession& session) {
+    int sourceId = chooseSource(session);
+    if (sourceId == -1) {
+        return {-1, -1};
     }
+    const StationGraph& graph = session.currentGraph();
+    double threshold = session.searchThreshold();
 
-    return {farthestNodeID, maxDistance};
-}
+    // Start timer
+    auto start = chrono::high_resolution_clock::now();
 
-vector<int> runDijkstras(const vector<Node>& nodes, const unordered_map<int, Node>& graph, const vector<Node>& newlyAdded, string inputS) {
-    if (nodes.empty()) {
-        cout << "No nodes." << endl;
-        return {-1, -1};
-    } else {
-        int sourceId = -1;
-        for (int i = 0; i < nodes.size(); ++i) {
-            if (!graph.at(nodes[i].id).neighbors.empty()) {
-                sourceId = nodes[i].id;
-                break;
-            }
-        }
-        if (sourceId == -1) {
-            cout << "No suitable source." << endl;
-            return {-1, -1};
-        }
+    pair<int, double> result = search(sourceId, graph, threshold);
+    // End timer
+    auto end = chrono::high_resolution_clock::now();
 
-        //if already added in this state
-        if(newlyAdded.size() > 0) {
-            for (int i = newlyAdded.size() - 1; i >= 0; i--) {
-                if (newlyAdded[i].stateOrProvince == inputS) {
-                    sourceId = newlyAdded[i].id;
-                    break;
-                }
-            }
-        }
-        cout << "Using source node: " << sourceId << endl;
+    // Calculate duration in nanoseconds
+    auto duration = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+    cout << name << " took " << duration << " nanoseconds." << endl;
 
-        // Start timer
-        auto start = chrono::high_resolution_clock::now();
+    // Display the results
+    return reportFarthest(sourceId, result);
+}
 
-        pair<int, double> result = dijkstra_alg(sourceId, graph);
-        // End timer
-        auto end = chrono::high_resolution_clock::now();
+vector<int> runDijkstras(const PlacementSession& session) {
+    return runSearch("Dijkstra's algorithm", dijkstra_alg, session);
+}
 
-        // Calculate duration in nanoseconds
-        auto duration = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
-        cout << "Dijkstra's algorithm took " << duration << " nanoseconds." << endl;
+vector<int> runBellmanFord(const PlacementSession& session) {
+    return runSearch("Bellman-Ford algorithm", bellman_ford, session);
+}
 
-        // Display the results
-        if (result.first != -1) {
-            cout << "The farthest node from node " << sourceId
-                 << " is node " << result.first
-                 << " with a distance of " << result.second << " km." << endl;
+vector<int> runRadixDijkstras(const PlacementSession& session) {
+    return runSearch("Dijkstra's algorithm (radix heap)", dijkstra_radix, session);
+}
 
-            return {sourceId, result.first};
-        } else {
-            cout << "No reachable nodes found from the source node." << endl;
-            return {-1, -1};
-        }
+// Same as runBellmanFord with the frontier-parallel version, which also reports how much work it did
+vector<int> runParallelBellmanFord(const PlacementSession& session) {
+    int sourceId = chooseSource(session);
+    if (sourceId == -1) {
+        return {-1, -1};
     }
+    BellmanFordStats stats;
+    auto start = chrono::high_resolution_clock::now();
+    pair<int, double> result = bellman_ford_parallel(sourceId, session.currentGraph(), session.searchThreshold(),
+                                                     &stats);
+    auto end = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+    cout << "Parallel Bellman-Ford algorithm took " << duration << " nanoseconds (" << stats.rounds
+         << " rounds, " << stats.relaxations << " relaxations, " << stats.improvements << " improvements, "
+         << stats.threads << " threads)." << endl;
+    return reportFarthest(sourceId, result);
 }
 
-vector<int> runBellmanFord(const vector<Node>& nodes, const unordered_map<int, Node>& graph, const vector<Node>& newlyAdded, const string& inputS) {
-    if (nodes.empty()) {
-        cout << "No nodes." << endl;
+// Finds the exact farthest pair of stations over all components and times it.
+// Returns {from id, to id}, or {-1, -1} if no two stations are connected.
+vector<int> runFarthestPair(const StationGraph& graph, double threshold) {
+    auto start = chrono::high_resolution_clock::now();
+    FarthestPair best = graphDiameter(graph, threshold);
+    auto end = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+
+    cout << "Farthest pair search took " << duration << " nanoseconds (" << best.searches << " searches)." << endl;
+    if (best.from == -1) {
+        cout << "No two stations are connected." << endl;
         return {-1, -1};
-    } else {
-        int sourceID = -1;
-
-        for (int i = 0; i < nodes.size(); i++) {
-            if (!graph.at(nodes[i].id).neighbors.empty()) {
-                sourceID = nodes[i].id;
-                break;
-            }
-        }
-        if (sourceID == -1) {
-            cout << "No suitable source node." << endl;
-            return {-1, -1};
-        }
-
-        if(newlyAdded.size() > 0) {
-            for (int i = newlyAdded.size() - 1; i >= 0; i--) {
-                if (newlyAdded[i].stateOrProvince == inputS) {
-                    sourceID = newlyAdded[i].id;
-                    break;
-                }
-            }
-        }
-
-        cout << "Using source node: " << sourceID << endl;
-
-        // Start timer
-        auto start = chrono::high_resolution_clock::now();
-
-        pair<int, double> result = bellman_ford(sourceID, graph);
-
-        // End timer after function is called
-        auto end = chrono::high_resolution_clock::now();
-
-        // Calculate duration in nanoseconds
-        auto duration = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
-        cout << "Bellman-Ford algorithm took " << duration << " nanoseconds." << endl;
-
-        // Display the results
-        if (result.first != -1) {
-            cout << "The farthest node from node " << sourceID << " is node " << result.first
-                 << " with a distance of " << result.second << " km." << endl;
-            // Return sourceID and farthest node ID as a vector
-            return {sourceID, result.first};
-        } else {
-            cout << "No reachable nodes found from the source node." << endl;
-            return {-1, -1};
-        }
     }
+    cout << "The farthest pair is node " << best.from << " and node " << best.to << " with a distance of "
+         << best.distance << " km (component of " << best.componentSize << " stations)." << endl;
+    return {best.from, best.to};
 }
 
-vector<double> cMidpoint(const Node& one, const Node& two){
-    double oneLat = one.latitude;
-    double oneLon = one.longitude;
-    double twoLat = two.latitude;
-    double twoLon = two.longitude;
-    double avgx = (oneLat + twoLat)/2;
-    double avgy = (oneLon + twoLon)/2;
-    vector<double> result;
-    result.push_back(avgx);
-    result.push_back(avgy);
-    return result;
+// Prints up to limit station ids from a list
+void printStationList(const vector<int>& ids, int limit) {
+    for (int i = 0; i < static_cast<int>(ids.size()) && i < limit; i++) {
+        cout << (i == 0 ? "" : ", ") << ids[i];
+    }
+    if (static_cast<int>(ids.size()) > limit) {
+        cout << " ... (" << ids.size() << " total)";
+    }
+    cout << endl;
 }
 
-int main() {
-
-    string csvFile = "../data/openchargemap_data.csv";
-    ifstream file(csvFile);
-    string line;
-
+// Computes every station's eccentricity and prints the state's center and periphery
+void runEccentricityReport(const StationGraph& graph, double threshold, EccentricityMethod method, const string& inputS) {
+    auto start = chrono::high_resolution_clock::now();
+    EccentricityReport report = allEccentricities(graph, threshold, method);
+    auto end = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+
+    cout << "Eccentricity report took " << duration << " nanoseconds (" << report.searches << " searches)." << endl;
+    cout << inputS << " has " << report.componentCount << " connected components; the largest has "
+         << report.largestComponentSize << " stations." << endl;
+    cout << "Radius: " << report.radius << " km, diameter: " << report.diameter << " km" << endl;
+    cout << "Center: ";
+    printStationList(report.center, 10);
+    cout << "Periphery: ";
+    printStationList(report.periphery, 10);
+}
 
-    if (!file.is_open()) {
-        cout << "Error: Could not open file " << csvFile << endl;
-        return 1;
+void printRoute(const StationGraph& graph, const Route& route, double threshold, int fromId, int toId) {
+    if (!route.found) {
+        cout << "Node " << toId << " cannot be reached from node " << fromId << " with "
+             << threshold << " km legs." << endl;
+        return;
     }
+    cout << "Route from node " << fromId << " to node " << toId << ": " << route.distance << " km in "
+         << route.path.size() - 1 << " legs" << endl;
+    for (int i = 0; i < static_cast<int>(route.path.size()); i++) {
+        const Node& node = graph.station(route.path[i]);
+        cout << "  " << route.path[i] << " (" << node.latitude << ", " << node.longitude << ")" << endl;
+    }
+}
 
-    cout << "File opened successfully!" << endl;
-
-    vector<Node> allNodes;
-    unordered_map<int, Node> graph;
-    vector<Node> newlyAdded;
-
-    //skip header since its column headers
-    getline(file, line);
-
-    int nodeId = 0;
-
-    unordered_map<string, string> stateToAbbreviation = {
-            // Full names
-            {"ALABAMA", "AL"}, {"ALASKA", "AK"}, {"ARIZONA", "AZ"}, {"ARKANSAS", "AR"}, {"CALIFORNIA", "CA"},
-            {"COLORADO", "CO"}, {"CONNECTICUT", "CT"}, {"DELAWARE", "DE"}, {"FLORIDA", "FL"}, {"GEORGIA", "GA"},
-            {"HAWAII", "HI"}, {"IDAHO", "ID"}, {"ILLINOIS", "IL"}, {"INDIANA", "IN"}, {"IOWA", "IA"},
-            {"KANSAS", "KS"}, {"KENTUCKY", "KY"}, {"LOUISIANA", "LA"}, {"MAINE", "ME"}, {"MARYLAND", "MD"},
-            {"MASSACHUSETTS", "MA"}, {"MICHIGAN", "MI"}, {"MINNESOTA", "MN"}, {"MISSISSIPPI", "MS"}, {"MISSOURI", "MO"},
-            {"MONTANA", "MT"}, {"NEBRASKA", "NE"}, {"NEVADA", "NV"}, {"NEW HAMPSHIRE", "NH"}, {"NEW JERSEY", "NJ"},
-            {"NEW MEXICO", "NM"}, {"NEW YORK", "NY"}, {"NORTH CAROLINA", "NC"}, {"NORTH DAKOTA", "ND"},
-            {"OHIO", "OH"}, {"OKLAHOMA", "OK"}, {"OREGON", "OR"}, {"PENNSYLVANIA", "PA"}, {"RHODE ISLAND", "RI"},
-            {"SOUTH CAROLINA", "SC"}, {"SOUTH DAKOTA", "SD"}, {"TENNESSEE", "TN"}, {"TEXAS", "TX"}, {"UTAH", "UT"},
-            {"VERMONT", "VT"}, {"VIRGINIA", "VA"}, {"WASHINGTON", "WA"}, {"WEST VIRGINIA", "WV"}, {"WISCONSIN", "WI"},
-            {"WYOMING", "WY"},
-            // Abbreviations mapped to themselves for easier lookup
-            {"AL", "AL"}, {"AK", "AK"}, {"AZ", "AZ"}, {"AR", "AR"}, {"CA", "CA"}, {"CO", "CO"}, {"CT", "CT"},
-            {"DE", "DE"}, {"FL", "FL"}, {"GA", "GA"}, {"HI", "HI"}, {"ID", "ID"}, {"IL", "IL"}, {"IN", "IN"},
-            {"IA", "IA"}, {"KS", "KS"}, {"KY", "KY"}, {"LA", "LA"}, {"ME", "ME"}, {"MD", "MD"}, {"MA", "MA"},
-            {"MI", "MI"}, {"MN", "MN"}, {"MS", "MS"}, {"MO", "MO"}, {"MT", "MT"}, {"NE", "NE"}, {"NV", "NV"},
-            {"NH", "NH"}, {"NJ", "NJ"}, {"NM", "NM"}, {"NY", "NY"}, {"NC", "NC"}, {"ND", "ND"}, {"OH", "OH"},
-            {"OK", "OK"}, {"OR", "OR"}, {"PA", "PA"}, {"RI", "RI"}, {"SC", "SC"}, {"SD", "SD"}, {"TN", "TN"},
-            {"TX", "TX"}, {"UT", "UT"}, {"VT", "VT"}, {"VA", "VA"}, {"WA", "WA"}, {"WV", "WV"}, {"WI", "WI"},
-            {"WY", "WY"}
-    };
-
-    // process each section of data
-    //the sections sometimes will span multiple lines so process it until the section is finished
-    while (file) {
-        string section;
-        int quoteCount = 0;
-        bool sectionStarted = false;
-
-        // Read lines until a complete section is formed
-        while (getline(file, line)) {
-            if (sectionStarted) {
-                // Preserve newline character within quoted fields
-                section += "\n";
-            }
-            section += line;
-            sectionStarted = true;
+// Finds and prints the shortest route between two stations
+void runRoute(const StationGraph& graph, double threshold, int fromId, int toId) {
+    if (!graph.contains(fromId) || !graph.contains(toId)) {
+        cout << "Both stations must be in the current state's graph." << endl;
+        return;
+    }
+    auto start = chrono::high_resolution_clock::now();
+    Route route = shortestRoute(graph, fromId, toId, threshold);
+    auto end = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
 
-            // Count the number of double quotes in the current section
-            quoteCount = count(section.begin(), section.end(), '"');
+    cout << "Route search took " << duration << " nanoseconds (" << route.settled << " nodes settled)." << endl;
+    printRoute(graph, route, threshold, fromId, toId);
+}
 
-            // If quoteCount is even, we have a complete section
-            if (quoteCount % 2 == 0) {
-                break;
+// Builds the state's contraction hierarchy, or loads it from the cache file when that was
+// built from the same stations and settings, then answers the route query from it
+void runHierarchyRoute(ContractionHierarchy& hierarchy, const StationGraph& graph, double threshold,
+                       const string& inputState, int fromId, int toId) {
+    if (!graph.contains(fromId) || !graph.contains(toId)) {
+        cout << "Both stations must be in the current state's graph." << endl;
+        return;
+    }
+    if (!hierarchy.matches(graph, threshold)) {
+        string cacheFile = "../data/" + inputState + "_" + graphModeName(graph.mode) + "_" +
+                           to_string(threshold) + ".ch";
+        if (hierarchy.load(cacheFile, graph, threshold)) {
+            cout << "Loaded contraction hierarchy from " << cacheFile << endl;
+        } else {
+            auto start = chrono::high_resolution_clock::now();
+            hierarchy.build(graph, threshold);
+            auto end = chrono::high_resolution_clock::now();
+            auto duration = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+            cout << "Contraction hierarchy build took " << duration << " nanoseconds ("
+                 << hierarchy.shortcutCount() << " shortcuts)." << endl;
+            if (!hierarchy.save(cacheFile)) {
+                cout << "Could not write " << cacheFile << endl;
             }
         }
+    }
+    auto start = chrono::high_resolution_clock::now();
+    Route route = hierarchy.route(fromId, toId);
+    auto end = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
 
-        if (section.empty()) {
-            // End of file
-            break;
-        }
-
-        vector<string> row = parseCSVLine(section);
-
-        // Handle incomplete rows
-        if (row.size() < 11) {
-            cout << "Warning: Incomplete or malformed row with ID: " << row[0] << endl;
-            continue;
-        }
-
-        if (!row[9].empty() && !row[10].empty()) {
-            // Convert Lat and Long to double
-            double latitude = stod(row[9]);
-            double longitude = stod(row[10]);
+    cout << "Hierarchy query took " << duration << " nanoseconds (" << route.settled << " nodes settled)." << endl;
+    printRoute(graph, route, threshold, fromId, toId);
+}
 
-            // Extract stateOrProvince and normalize to abbreviation
-            string stateOrProvince = row[6];
-            transform(stateOrProvince.begin(), stateOrProvince.end(), stateOrProvince.begin(), ::toupper);
+// Bounds the distance between two stations from the landmark tables, then finds the exact
+// route with landmark-guided A*. The tables are built on first use for the state and threshold.
+void runLandmarkRoute(LandmarkOracle& oracle, const StationGraph& graph, double threshold, int fromId, int toId) {
+    if (!graph.contains(fromId) || !graph.contains(toId)) {
+        cout << "Both stations must be in the current state's graph." << endl;
+        return;
+    }
+    if (!oracle.matches(graph, threshold)) {
+        auto start = chrono::high_resolution_clock::now();
+        oracle.build(graph, threshold);
+        auto end = chrono::high_resolution_clock::now();
+        auto duration = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+        cout << "Landmark selection took " << duration << " nanoseconds (" << oracle.landmarkCount()
+             << " landmarks)." << endl;
+    }
+    auto start = chrono::high_resolution_clock::now();
+    DistanceBounds bounds = oracle.bounds(fromId, toId);
+    auto end = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+    cout << "Landmark bounds took " << duration << " nanoseconds: between " << bounds.lower << " and "
+         << bounds.upper << " km." << endl;
+
+    start = chrono::high_resolution_clock::now();
+    Route route = oracle.route(graph, fromId, toId);
+    end = chrono::high_resolution_clock::now();
+    duration = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+    cout << "Landmark A* took " << duration << " nanoseconds (" << route.settled << " nodes settled)." << endl;
+    printRoute(graph, route, threshold, fromId, toId);
+}
 
-            if (stateToAbbreviation.find(stateOrProvince) != stateToAbbreviation.end()) {
-                stateOrProvince = stateToAbbreviation[stateOrProvince];
-            }
+// Lists the stations within a route distance of a station, nearest first
+void runRange(RangeSearch& search, double threshold, int Id, double radius) {
+    auto start = chrono::high_resolution_clock::now();
+    const vector<pair<int, double>>& stations = search.within(Id, radius, threshold);
+    auto end = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::nanoseconds>(end - start).count();
+
+    cout << "Range search took " << duration << " nanoseconds (" << search.touchedCount() << " nodes touched)." << endl;
+    if (stations.empty()) {
+        cout << "Node " << Id << " is not in the current state's graph." << endl;
+        return;
+    }
+    cout << stations.size() - 1 << " stations within " << radius << " km of node " << Id << " using "
+         << threshold << " km legs:" << endl;
+    for (int i = 1; i < static_cast<int>(stations.size()) && i <= 10; i++) {
+        cout << "  " << stations[i].first << " (" << stations[i].second << " km)" << endl;
+    }
+    if (stations.size() > 11) {
+        cout << "  ... (" << stations.size() - 1 << " total)" << endl;
+    }
+}
 
-            // Check if the stateOrProvince is a U.S. state
-            if (stateToAbbreviation.find(stateOrProvince) != stateToAbbreviation.end()) {
-                // Create a node and add it to the list
-                Node node;
-                node.id = nodeId++;
-                node.latitude = latitude;
-                node.longitude = longitude;
-                node.stateOrProvince = stateOrProvince;
+// Turns timing and counters on or off, shows them, or writes them out as JSON
+void runInstrumentationMenu() {
+    cout << "\nTiming and counters are " << (instrumentationEnabled() ? "on" : "off") << "." << endl;
+    cout << "1. Turn " << (instrumentationEnabled() ? "off" : "on") << endl;
+    cout << "2. Show summary" << endl;
+    cout << "3. Write JSON to instrumentation.json" << endl;
+    cout << "4. Reset" << endl;
+    cout << "Enter your choice: " << endl;
+    string input;
+    cin >> input;
+    if (input == "1") {
+        setInstrumentationEnabled(!instrumentationEnabled());
+        cout << "Timing and counters turned " << (instrumentationEnabled() ? "on" : "off") << "." << endl;
+    } else if (input == "2") {
+        printInstrumentation(cout);
+    } else if (input == "3") {
+        ofstream out("instrumentation.json");
+        if (!out.is_open()) {
+            cout << "Error: Could not open file instrumentation.json" << endl;
+            return;
+        }
+        writeInstrumentationJSON(out);
+        cout << "Wrote instrumentation.json" << endl;
+    } else if (input == "4") {
+        resetInstrumentation();
+        cout << "Timing and counters reset." << endl;
+    } else {
+        cout << "Choose valid option" << endl;
+    }
+}
 
-                allNodes.push_back(node);
-            } else {
-                // Skip nodes not in the U.S.
-                continue;
-            }
+int main(int argc, char* argv[]) {
+    // --stats records from startup, so loading and the first build are included;
+    // --trace FILE writes a Chrome trace of the whole session to FILE on exit;
+    // --threads N runs every parallel stage on N threads instead of one per core.
+    // --serve answers queries over a socket (see server.h); any other option runs headless
+    // instead of showing the menu (see batch.h).
+    vector<string> batchArguments;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--stats") {
+            setInstrumentationEnabled(true);
+        } else if (string(argv[i]) == "--trace" && i + 1 < argc) {
+            startTracing(argv[++i]);
+        } else if (string(argv[i]) == "--threads" && i + 1 < argc) {
+            setWorkerCount(atoi(argv[++i]));
         } else {
-            cout << "Warning: Missing latitude/longitude in row ID: " << row[0] << endl;
+            batchArguments.push_back(argv[i]);
         }
-
     }
+    if (find(batchArguments.begin(), batchArguments.end(), "--serve") != batchArguments.end()) {
+        return runServer(batchArguments);
+    }
+    if (!batchArguments.empty()) {
+        return runBatch(batchArguments);
+    }
+
+    string csvFile = "../data/openchargemap_data.csv";
+    vector<Node> allNodes;
+    vector<Node> newlyAdded;
 
-    file.close();
+    // Multi-charger sites are often entered once per charger; treat them as one site
+    double collapseEpsilonKm = 0.025;
+    // Stations placed in earlier runs come back from the journal kept next to the data file.
+    // A placement made here is synced to it before the next prompt.
+    PlacementJournal journal(csvFile, 1);
+    JournalLoad loaded = journal.load(allNodes, collapseEpsilonKm);
+    if (loaded.inUse) {
+        cout << "Error: " << journal.journalPath() << " is in use by another program, such as a server on the same file" << endl;
+        return 1;
+    }
+    if (!loaded.loaded) {
+        return 1;
+    }
+    const unordered_map<string, string>& stateToAbbreviation = stateAbbreviations();
 
     if (allNodes.empty()) {
         cout << "No stations found in the United States." << endl;
         return 1;
     }
 
+    int siteCount = allNodes.size() - loaded.placed;
+    if (loaded.fromSnapshot) {
+        cout << "Loaded " << siteCount << " sites from " << journal.snapshotPath() << "." << endl;
+    } else {
+        cout << "Collapsed " << loaded.merged << " of " << loaded.rows << " stations within "
+             << collapseEpsilonKm * 1000 << " m of another into " << siteCount << " sites." << endl;
+    }
+    if (loaded.placed > 0) {
+        cout << "Restored " << loaded.placed << " stations placed in earlier runs (" << loaded.replayed
+             << " from " << journal.journalPath() << ")." << endl;
+        newlyAdded.assign(allNodes.end() - loaded.placed, allNodes.end());
+    }
+    // stations placed here are numbered on from the highest id loaded
+    int nextStationId = loaded.nextId;
+
     // Prompt the user for the U.S. state
     string inputState;
     cout << "Enter the U.S. state you would like the stations in (e.g., 'CA' or 'California'): " << endl;
@@ -427,6 +391,19 @@ int main() {
 
     bool running = true;
 
+    // Graphs are built once up to graphOptions.maxRadius; any smaller threshold is answered without a rebuild
+    GraphOptions graphOptions;
+    double thresholdDistance = 2.0;
+    // Rebuilt (or reloaded from disk) only when the state, mode or threshold changes
+    ContractionHierarchy hierarchy;
+    // Kept up to date incrementally as stations are placed
+    LandmarkOracle landmarkOracle;
+    // The current state's stations and graph, which placements go through
+    unique_ptr<PlacementSession> session;
+    // Made again whenever the graph is, and keeps its buffers between range queries on the same graph
+    unique_ptr<RangeSearch> rangeSearch;
+    unsigned long long rangeGeneration = 0;
+
     while (running) {
 
         // Normalize input state to abbreviation
@@ -434,7 +411,7 @@ int main() {
 
         // Check if the input is a full state name
         if (stateToAbbreviation.find(inputState) != stateToAbbreviation.end()) {
-            inputState = stateToAbbreviation[inputState]; // Convert to abbreviation
+            inputState = stateToAbbreviation.at(inputState); // Convert to abbreviation
         }
 
         // Validate if inputState is now a valid U.S. state abbreviation
@@ -445,17 +422,20 @@ int main() {
         }
 
 
+        // in a trace, switching to the state and everything done with it nest under this span
+        TraceScope stateSession("state", inputState);
+
         // Clear previous graph and nodes for old state
-        graph.clear();
+        session.reset();
         vector<Node> nodes;
 
         // Filter nodes based on the input state
-        for (const auto &node: allNodes) {
-            string nodeState = node.stateOrProvince;
-
-            if (node.stateOrProvince == inputState) {
-                nodes.push_back(node);
-                graph[node.id] = node;
+        {
+            ScopedTimer timer("state.filter");
+            for (const auto &node: allNodes) {
+                if (node.stateOrProvince == inputState) {
+                    nodes.push_back(node);
+                }
             }
         }
 
@@ -474,32 +454,57 @@ int main() {
 
         cout << "\nNumber of stations in " << inputState << ": " << nodes.size() << endl;
 
-        double thresholdDistance = 2.0;
-
         // Build the graph
-        buildGraph(nodes, thresholdDistance, graph);
-        cout << "Graph built successfully!" << endl;
+        printBuilding(graphOptions);
+        session.reset(new PlacementSession(inputState, nodes, graphOptions, thresholdDistance));
+        cout << "Graph built successfully! (" << session->currentGraph().edgeCount(session->searchThreshold())
+             << " edges)" << endl;
+        // the next placement starts from the last one made in this state, in this run or an earlier one
+        for (int i = newlyAdded.size() - 1; i >= 0; i--) {
+            if (newlyAdded[i].stateOrProvince == inputState) {
+                session->resume(newlyAdded[i].id);
+                break;
+            }
+        }
 
         // User menu
         while (true) {
+            // taken again on every pass, since placing a station or rebuilding replaces the session's graph
+            const StationGraph& graph = session->currentGraph();
             cout << "\nMenu:" << endl;
             cout << "1. Change state" << endl;
             cout << "2. Find best location for new node using Dijkstra's algorithm" << endl;
             cout << "3. Find best location for new node using Bellman Ford's Algorithm" << endl;
             cout << "4. Place a new optimized station(node) in the graph using an Algorithm" << endl;
-            cout << "5. Exit" << endl;
+            cout << "5. Change connection threshold (current: " << thresholdDistance << " km)" << endl;
+            cout << "6. Change graph construction mode (current: " << graphModeName(graph.mode);
+            if (graph.mode == GraphMode::KNearest) {
+                cout << ", k = " << graph.k;
+            }
+            cout << ")" << endl;
+            cout << "7. Find best location for new node using Dijkstra's algorithm with a radix heap" << endl;
+            cout << "8. Find the farthest pair of stations in the graph (exact)" << endl;
+            cout << "9. Eccentricity report with the state's center and periphery" << endl;
+            cout << "10. Find the shortest route between two stations" << endl;
+            cout << "11. Find the shortest route between two stations using a contraction hierarchy" << endl;
+            cout << "12. Bound and find the shortest route between two stations using landmarks" << endl;
+            cout << "13. List the stations within a route distance of a station" << endl;
+            cout << "14. Find best location for new node using parallel Bellman Ford" << endl;
+            cout << "15. Timing and counters (" << (instrumentationEnabled() ? "on" : "off") << ")" << endl;
+            cout << "0. Exit" << endl;
             cout << "Enter your choice: " << endl;
 
 
             string choice1;
             cin >> choice1;
             int choice;
+            double threshold = session->searchThreshold();
 
             //input validation
             try {
                 choice = stoi(choice1);
-            } catch (const invalid_argument&) {
-                cout << "Invalid input. Please enter a number between 1 and 5." << endl;
+            } catch (const logic_error&) {
+                cout << "Invalid input. Please enter a number between 0 and 15." << endl;
                 continue;
             }
 
@@ -511,15 +516,19 @@ int main() {
                 // Break inner loop to rebuild graph with new state
                 break;
             } else if (choice == 2) {
-                runDijkstras(nodes, graph, newlyAdded, inputState);
+                runDijkstras(*session);
             }
             else if (choice == 3) {
-                runBellmanFord(nodes, graph, newlyAdded, inputState);
+                runBellmanFord(*session);
             }
             else if(choice == 4){
                 cout << "\nWhich algorithm would you like to use?" << endl;
                 cout << "1. Dijkstra's" << endl;
                 cout << "2. Bellman Ford" << endl;
+                cout << "3. Dijkstra's (radix heap)" << endl;
+                cout << "4. Exact farthest pair" << endl;
+                cout << "5. Dijkstra's, updated incrementally after each placement" << endl;
+                cout << "6. Bellman Ford (parallel)" << endl;
                 cout << "Enter your choice: " << endl;
                 string choice1;
                 cin >> choice1;
@@ -528,116 +537,220 @@ int main() {
                 //input validation
                 try {
                     choice2 = stoi(choice1);
-                } catch (const invalid_argument&) {
-                    cout << "Invalid input. Please enter a number between 1 and 5." << endl;
+                } catch (const logic_error&) {
+                    cout << "Invalid input. Please enter a number between 1 and 6." << endl;
                     continue;
                 }
 
+                if (choice2 < 1 || choice2 > 6) {
+                    cout << "Choose valid option" << endl;
+                    continue;
+                }
+                // the choices are listed in PlacementAlgorithm's order
+                PlacementAlgorithm algorithm = static_cast<PlacementAlgorithm>(choice2 - 1);
+                bool landmarksCurrent = landmarkOracle.matches(graph, threshold);
+                // a threshold graph takes the new station in place, a k-nearest one is built again
+                bool rebuilds = graph.mode == GraphMode::KNearest;
+                if (rebuilds) {
+                    printBuilding(graphOptions);
+                }
+                Placement placement = session->place(algorithm, nextStationId);
+                if (!placement.placed) {
+                    cout << (session->nextSource() == -1 ? "No suitable source."
+                                                         : "No reachable nodes found from the source node.")
+                         << endl;
+                    continue;
+                }
+                cout << "Using source node: " << placement.sourceId << endl;
+                cout << "Search (" << placementAlgorithmName(algorithm) << ") took " << placement.searchNs
+                     << " nanoseconds." << endl;
+                cout << "The farthest node from node " << placement.sourceId << " is node " << placement.farthestId
+                     << " with a distance of " << placement.distance << " km." << endl;
+                const Node& add = placement.station;
+                cout << "New Station Location Added! (midpoint):" << endl;
+                cout << "Latitude: " << add.latitude << ", Longitude: " << add.longitude << endl;
+                nextStationId++;
+                allNodes.push_back(add);
+                newlyAdded.push_back(add);
+                if (!journal.append(add)) {
+                    cout << "Warning: Could not write " << journal.journalPath()
+                         << "; the station is saved with the next placement or on exit if it can be." << endl;
+                }
 
-                if(choice2 == 1){
-                    vector<int> values = runDijkstras(nodes, graph, newlyAdded, inputState);
-                    int source = values[0];
-                    int farthest = values[1];
-                    if (source != -1 && farthest != -1) {
-                        if (graph.find(source) != graph.end() && graph.find(farthest) != graph.end()) {
-                            Node sourceNode = graph.find(source)->second;
-                            Node farthestNode = graph.find(farthest)->second;
-                            vector<double> midpoint = cMidpoint(sourceNode, farthestNode);
-                            cout << "New Station Location Added! (midpoint):" << endl;
-                            cout << "Latitude: " << midpoint[0] << ", Longitude: " << midpoint[1] << endl;
-                            Node add;
-                            add.latitude = midpoint[0];
-                            add.longitude = midpoint[1];
-                            add.id = allNodes.size();
-                            add.stateOrProvince = inputState;
-                            allNodes.push_back(add);
-                            newlyAdded.push_back(add);
-
-                            // Clear previous graph and nodes for old state
-                            graph.clear();
-                            vector<Node> nodes;
-
-                            // Filter nodes based on the input state
-                            for (const auto &node: allNodes) {
-                                string nodeState = node.stateOrProvince;
-
-                                if (node.stateOrProvince == inputState) {
-                                    nodes.push_back(node);
-                                    graph[node.id] = node;
-                                }
-                            }
-
-                            cout << "\nNumber of stations in " << inputState << ": " << nodes.size() << endl;
-
-                            thresholdDistance = 2.0;
-
-                            // Build the graph
-                            buildGraph(nodes, thresholdDistance, graph);
-                            cout << "Graph built successfully!" << endl;
-                        }
-                        else{
-                            cout << "Not in graph" << endl;
-                        }
-                    }
+                const StationGraph& rebuilt = session->currentGraph();
+                cout << "\nNumber of stations in " << inputState << ": " << rebuilt.size() << endl;
+                cout << (rebuilds ? "Graph built successfully! (" : "Station added to the graph! (")
+                     << placement.rebuildNs << " nanoseconds)" << endl;
+                if (landmarksCurrent) {
+                    landmarkOracle.addStation(rebuilt, add.id);
+                }
+            }
+            else if (choice == 5) {
+                cout << "Enter the new connection threshold in km: " << endl;
+                string thresholdInput;
+                cin >> thresholdInput;
+                double newThreshold;
+                try {
+                    newThreshold = stod(thresholdInput);
+                } catch (const logic_error&) {
+                    cout << "Invalid input. Please enter a distance in km." << endl;
+                    continue;
                 }
-                else if(choice2 == 2) {
-                    vector<int> values = runBellmanFord(nodes, graph, newlyAdded, inputState);
-                    int source = values[0];
-                    int farthest = values[1];
-                    if (source != -1 && farthest != -1) {
-                        if (graph.find(source) != graph.end() && graph.find(farthest) != graph.end()) {
-                            Node sourceNode = graph.find(source)->second;
-                            Node farthestNode = graph.find(farthest)->second;
-                            vector<double> midpoint = cMidpoint(sourceNode, farthestNode);
-                            cout << "Suggested location (midpoint):" << endl;
-                            cout << "Latitude: " << midpoint[0] << ", Longitude: " << midpoint[1] << endl;
-                            Node add;
-                            add.latitude = midpoint[0];
-                            add.longitude = midpoint[1];
-                            add.id = allNodes.size();
-                            add.stateOrProvince = inputState;
-                            allNodes.push_back(add);
-                            newlyAdded.push_back(add);
-
-                            // Clear previous graph and nodes for old state
-                            graph.clear();
-                            vector<Node> nodes;
-
-                            // Filter nodes based on the input state
-                            for (const auto &node: allNodes) {
-                                string nodeState = node.stateOrProvince;
-
-                                if (node.stateOrProvince == inputState) {
-                                    nodes.push_back(node);
-                                    graph[node.id] = node;
-                                }
-                            }
-
-                            cout << "Number of stations in " << inputState << ": " << nodes.size() << endl;
-
-                            thresholdDistance = 2.0;
-
-                            // Build the graph
-                            buildGraph(nodes, thresholdDistance, graph);
-                            cout << "Graph built successfully!" << endl;
-                        }
-                        else{
-                            cout << "Not in graph" << endl;
-                        }
+                if (!(newThreshold > 0.0) || !isfinite(newThreshold)) {
+                    cout << "Threshold must be a finite distance greater than 0 km." << endl;
+                    continue;
+                }
+                thresholdDistance = newThreshold;
+                session->setThreshold(thresholdDistance);
+                if (graph.mode == GraphMode::KNearest) {
+                    cout << "Threshold set to " << thresholdDistance
+                         << " km (used once the graph is back in threshold mode)." << endl;
+                    continue;
+                }
+                // Only a threshold beyond the built radius needs a rebuild, smaller ones are prefixes
+                if (thresholdDistance > graph.maxRadius) {
+                    graphOptions.maxRadius = thresholdDistance;
+                    printBuilding(graphOptions);
+                    session->rebuild(graphOptions);
+                }
+                cout << "Threshold set to " << thresholdDistance << " km ("
+                     << session->currentGraph().edgeCount(thresholdDistance) << " edges)." << endl;
+            }
+            else if (choice == 6) {
+                cout << "\nHow should stations be connected?" << endl;
+                cout << "1. Every station within the threshold distance" << endl;
+                cout << "2. Each station to its k nearest stations" << endl;
+                cout << "Enter your choice: " << endl;
+                string modeInput;
+                cin >> modeInput;
+                if (modeInput == "1") {
+                    graphOptions.mode = GraphMode::Threshold;
+                    graphOptions.maxRadius = max(graphOptions.maxRadius, thresholdDistance);
+                } else if (modeInput == "2") {
+                    cout << "Enter k (neighbors per station): " << endl;
+                    string kInput;
+                    cin >> kInput;
+                    int k;
+                    try {
+                        k = stoi(kInput);
+                    } catch (const logic_error&) {
+                        cout << "Invalid input. Please enter a whole number." << endl;
+                        continue;
+                    }
+                    if (k < 1) {
+                        cout << "k must be at least 1." << endl;
+                        continue;
                     }
+                    graphOptions.mode = GraphMode::KNearest;
+                    graphOptions.k = k;
+                } else {
+                    cout << "Choose valid option" << endl;
+                    continue;
                 }
-                else {
+                printBuilding(graphOptions);
+                session->rebuild(graphOptions);
+                cout << "Graph built successfully! (" << session->currentGraph().edgeCount(session->searchThreshold())
+                     << " edges)" << endl;
+            }
+            else if (choice == 7) {
+                runRadixDijkstras(*session);
+            }
+            else if (choice == 8) {
+                runFarthestPair(graph, threshold);
+            }
+            else if (choice == 9) {
+                cout << "\nHow should eccentricities be computed?" << endl;
+                cout << "1. One search from every station" << endl;
+                cout << "2. One search per " << BATCH_LANES << " stations (batched)" << endl;
+                cout << "3. Prune with eccentricity bounds" << endl;
+                cout << "Enter your choice: " << endl;
+                string methodInput;
+                cin >> methodInput;
+                if (methodInput == "1") {
+                    runEccentricityReport(graph, threshold, EccentricityMethod::PerSource, inputState);
+                } else if (methodInput == "2") {
+                    runEccentricityReport(graph, threshold, EccentricityMethod::Batched, inputState);
+                } else if (methodInput == "3") {
+                    runEccentricityReport(graph, threshold, EccentricityMethod::Bounded, inputState);
+                } else {
                     cout << "Choose valid option" << endl;
                 }
             }
-            else if (choice == 5) {
-                // Exit
+            else if (choice == 10) {
+                cout << "Enter the starting and destination node ids: " << endl;
+                string fromInput, toInput;
+                cin >> fromInput >> toInput;
+                int fromId, toId;
+                try {
+                    fromId = stoi(fromInput);
+                    toId = stoi(toInput);
+                } catch (const logic_error&) {
+                    cout << "Invalid input. Please enter two node ids." << endl;
+                    continue;
+                }
+                runRoute(graph, threshold, fromId, toId);
+            }
+            else if (choice == 11) {
+                cout << "Enter the starting and destination node ids: " << endl;
+                string fromInput, toInput;
+                cin >> fromInput >> toInput;
+                int fromId, toId;
+                try {
+                    fromId = stoi(fromInput);
+                    toId = stoi(toInput);
+                } catch (const logic_error&) {
+                    cout << "Invalid input. Please enter two node ids." << endl;
+                    continue;
+                }
+                runHierarchyRoute(hierarchy, graph, threshold, inputState, fromId, toId);
+            }
+            else if (choice == 12) {
+                cout << "Enter the starting and destination node ids: " << endl;
+                string fromInput, toInput;
+                cin >> fromInput >> toInput;
+                int fromId, toId;
+                try {
+                    fromId = stoi(fromInput);
+                    toId = stoi(toInput);
+                } catch (const logic_error&) {
+                    cout << "Invalid input. Please enter two node ids." << endl;
+                    continue;
+                }
+                runLandmarkRoute(landmarkOracle, graph, threshold, fromId, toId);
+            }
+            else if (choice == 13) {
+                cout << "Enter the node id and the route distance in km: " << endl;
+                string idInput, radiusInput;
+                cin >> idInput >> radiusInput;
+                int Id;
+                double radius;
+                try {
+                    Id = stoi(idInput);
+                    radius = stod(radiusInput);
+                } catch (const logic_error&) {
+                    cout << "Invalid input. Please enter a node id and a distance." << endl;
+                    continue;
+                }
+                if (!rangeSearch || rangeGeneration != graph.generation) {
+                    rangeSearch.reset(new RangeSearch(graph));
+                    rangeGeneration = graph.generation;
+                }
+                runRange(*rangeSearch, threshold, Id, radius);
+            }
+            else if (choice == 14) {
+                runParallelBellmanFord(*session);
+            }
+            else if (choice == 15) {
+                runInstrumentationMenu();
+            }
+            else if (choice == 0) {
+                // Exit (kept on 0 so scripted input still works as options are added)
                 running = false;
                 cout << "Exiting" << endl;
                 break;
             } else {
                 //fix
-                cout << "Invalid choice. Please enter 1, 2, 3, 4, or 5." << endl;
+                cout << "Invalid choice. Please enter a number between 0 and 15." << endl;
             }
         }
     }
@@ -0,0 +1,62 @@
+#include "parallel.h"
+#include "task_pool.h"
+#include "trace.h"
+
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+// Chunks per worker in parallelFor; more than one lets idle workers steal from busy ones
+const int CHUNKS_PER_WORKER = 4;
+
+atomic<int> configuredWorkers(0);
+}
+
+int workerCount() {
+    int configured = configuredWorkers.load(memory_order_relaxed);
+    if (configured > 0) {
+        return configured;
+    }
+    unsigned int count = thread::hardware_concurrency();
+    return count == 0 ? 1 : static_cast<int>(count);
+}
+
+void setWorkerCount(int count) {
+    configuredWorkers.store(max(0, count), memory_order_relaxed);
+}
+
+TaskPool& scheduler() {
+    static TaskPool pool(workerCount() - 1);
+    return pool;
+}
+
+void parallelFor(int begin, int end, const function<void(int, int)>& body) {
+    int total = end - begin;
+    if (total <= 0) {
+        return;
+    }
+    int workers = workerCount();
+    int chunks = min(workers == 1 ? 1 : workers * CHUNKS_PER_WORKER, total);
+    if (chunks == 1) {
+        body(begin, end);
+        return;
+    }
+
+    // each chunk is traced on the thread that ran it
+    auto run = [&body](int chunkBegin, int chunkEnd) {
+        TraceScope trace("parallel.chunk");
+        body(chunkBegin, chunkEnd);
+    };
+    TaskGroup group(scheduler());
+    int chunkSize = (total + chunks - 1) / chunks;
+    for (int start = begin + chunkSize; start < end; start += chunkSize) {
+        int chunkEnd = min(start + chunkSize, end);
+        group.run([&run, start, chunkEnd] { run(start, chunkEnd); });
+    }
+    // the calling thread takes the first chunk, then helps with the rest
+    run(begin, min(begin + chunkSize, end));
+    group.wait();
+}
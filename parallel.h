@@ -0,0 +1,24 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_PARALLEL_H
+#define EV_CHARGING_STATION_OPTIMIZATION_PARALLEL_H
+
+#include <functional>
+
+class TaskPool;
+
+// Number of threads parallel stages split their work across: the hardware's, unless set
+int workerCount();
+
+// Sets the number of threads for the whole program (--threads). Must be called before the first
+// parallel stage, since the scheduler is sized once; 0 goes back to the hardware's count.
+void setWorkerCount(int count);
+
+// The work-stealing pool every parallel stage runs on, created on first use with
+// workerCount() - 1 threads; the thread waiting on a stage's tasks runs them too
+TaskPool& scheduler();
+
+// Splits [begin, end) into contiguous chunks, a few per worker so a slow chunk can be balanced
+// by stealing, and runs body(chunkBegin, chunkEnd) on each; returns when every chunk has finished.
+// Can be called from inside another parallel stage.
+void parallelFor(int begin, int end, const std::function<void(int, int)>& body);
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_PARALLEL_H
@@ -0,0 +1,165 @@
+#include "placement.h"
+#include "shortest_paths.h"
+#include "diameter.h"
+#include "instrumentation.h"
+
+#include <chrono>
+
+using namespace std;
+
+namespace {
+const char* const ALGORITHM_NAMES[] = {
+        "dijkstra", "bellman_ford", "radix", "farthest_pair", "incremental", "parallel_bellman_ford"
+};
+
+long long nanosecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+}
+
+bool parsePlacementAlgorithm(const string& name, PlacementAlgorithm& algorithm) {
+    for (int i = 0; i < 6; i++) {
+        if (name == ALGORITHM_NAMES[i]) {
+            algorithm = static_cast<PlacementAlgorithm>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* placementAlgorithmName(PlacementAlgorithm algorithm) {
+    return ALGORITHM_NAMES[static_cast<int>(algorithm)];
+}
+
+PlacementSession::PlacementSession(const string& state, const vector<Node>& nodes, const GraphOptions& options,
+                                   double threshold)
+        : stateName(state), nodes(nodes), options(options), threshold(threshold) {
+    auto start = chrono::steady_clock::now();
+    current = make_shared<StationGraph>();
+    buildGraph(this->nodes, this->options, *current);
+    firstBuildNs = nanosecondsSince(start);
+}
+
+double PlacementSession::searchThreshold() const {
+    return current->mode == GraphMode::KNearest ? current->maxRadius : threshold;
+}
+
+void PlacementSession::resume(int stationId) {
+    if (current->contains(stationId)) {
+        lastPlaced = stationId;
+    }
+}
+
+int PlacementSession::nextSource() const {
+    int first = firstConnected();
+    return first == -1 || lastPlaced == -1 ? first : lastPlaced;
+}
+
+void PlacementSession::rebuild(const GraphOptions& options) {
+    this->options = options;
+    shared_ptr<StationGraph> rebuilt = make_shared<StationGraph>();
+    buildGraph(nodes, this->options, *rebuilt);
+    current = rebuilt;
+    grid.reset();
+}
+
+int PlacementSession::firstConnected() const {
+    const StationGraph& graph = *current;
+    double active = searchThreshold();
+    int sourceId = -1;
+    for (int i = 0; i < graph.size(); ++i) {
+        if (graph.degree(i, active) > 0 && (sourceId == -1 || graph.nodes[i].id < sourceId)) {
+            sourceId = graph.nodes[i].id;
+        }
+    }
+    return sourceId;
+}
+
+Placement PlacementSession::place(PlacementAlgorithm algorithm, int id) {
+    return place(algorithm, [id](Node& station) { station.id = id; });
+}
+
+Placement PlacementSession::place(PlacementAlgorithm algorithm, const function<void(Node&)>& assign) {
+    ScopedTimer timer("placement");
+    const StationGraph& graph = *current;
+    Placement placement;
+    double active = searchThreshold();
+    // only needed before the first placement; a search from the last one finds nothing without edges
+    int sourceId = lastPlaced != -1 ? lastPlaced : firstConnected();
+    if (sourceId == -1) {
+        return placement;
+    }
+
+    auto start = chrono::steady_clock::now();
+    pair<int, double> result;
+    if (algorithm == PlacementAlgorithm::Dijkstra) {
+        result = dijkstra_alg(sourceId, graph, active);
+    } else if (algorithm == PlacementAlgorithm::BellmanFord) {
+        result = bellman_ford(sourceId, graph, active);
+    } else if (algorithm == PlacementAlgorithm::RadixDijkstra) {
+        result = dijkstra_radix(sourceId, graph, active);
+    } else if (algorithm == PlacementAlgorithm::ParallelBellmanFord) {
+        result = bellman_ford_parallel(sourceId, graph, active);
+    } else if (algorithm == PlacementAlgorithm::FarthestPair) {
+        FarthestPair best = graphDiameter(graph, active);
+        sourceId = best.from;
+        result = {best.to, best.distance};
+    } else {
+        // the incremental search keeps its own source from one placement to the next
+        if (!incremental.matches(graph, active)) {
+            int first = firstConnected();
+            if (first == -1) {
+                return placement;
+            }
+            incremental.reset(graph, first, active);
+        }
+        sourceId = incremental.source();
+        result = incremental.farthest();
+    }
+    placement.searchNs = nanosecondsSince(start);
+    if (sourceId == -1 || result.first == -1) {
+        return placement;
+    }
+
+    const Node& from = graph.station(sourceId);
+    const Node& to = graph.station(result.first);
+    placement.placed = true;
+    placement.sourceId = sourceId;
+    placement.farthestId = result.first;
+    placement.distance = result.second;
+    placement.station.latitude = (from.latitude + to.latitude) / 2;
+    placement.station.longitude = (from.longitude + to.longitude) / 2;
+    placement.station.stateOrProvince = stateName;
+    assign(placement.station);
+    int id = placement.station.id;
+
+    start = chrono::steady_clock::now();
+    nodes.push_back(placement.station);
+    bool distancesCurrent = incremental.matches(graph, active);
+    if (graph.mode == GraphMode::KNearest) {
+        // the new station can push another out of a k-nearest list, taking edges away
+        shared_ptr<StationGraph> rebuilt = make_shared<StationGraph>();
+        buildGraph(nodes, options, *rebuilt);
+        current = rebuilt;
+    } else {
+        if (current.use_count() > 1) {
+            // someone still reads this one through sharedGraph(), so change a copy
+            current = make_shared<StationGraph>(*current);
+            grid.reset();
+        }
+        if (!grid) {
+            grid.reset(new SpatialGrid(current->nodes));
+        }
+        const Node& station = placement.station;
+        int v = current->insert(station, grid->within(station.latitude, station.longitude, current->maxRadius));
+        if (!grid->add(v)) {
+            grid.reset();
+        }
+    }
+    if (distancesCurrent) {
+        incremental.insert(*current, id);
+    }
+    placement.rebuildNs = nanosecondsSince(start);
+    lastPlaced = id;
+    return placement;
+}
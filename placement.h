@@ -0,0 +1,90 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_PLACEMENT_H
+#define EV_CHARGING_STATION_OPTIMIZATION_PLACEMENT_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+
+#include "graph.h"
+#include "incremental_sssp.h"
+#include "spatial_index.h"
+
+// The searches the placement option can use to find the two stations to place between
+enum class PlacementAlgorithm {
+    Dijkstra,
+    BellmanFord,
+    RadixDijkstra,
+    FarthestPair,
+    IncrementalDijkstra,
+    ParallelBellmanFord
+};
+
+// Names as written on the command line: dijkstra, bellman_ford, radix, farthest_pair,
+// incremental, parallel_bellman_ford. Returns false for anything else.
+bool parsePlacementAlgorithm(const std::string& name, PlacementAlgorithm& algorithm);
+const char* placementAlgorithmName(PlacementAlgorithm algorithm);
+
+// Outcome of one placement
+struct Placement {
+    bool placed = false;
+    int sourceId = -1;
+    int farthestId = -1;
+    double distance = 0.0;  // km between source and farthest
+    Node station;           // the new station, at their midpoint
+    long long searchNs = 0;
+    long long rebuildNs = 0;  // adding the station to the graph, in place or by a rebuild
+};
+
+// One state's stations and graph, placing stations one after another without any prompts or
+// output, for the menu's placement option and the headless and server modes: search from the
+// station placed last (or the lowest id with an edge), put a new station at the midpoint of the
+// source and the farthest station found, and add it to the graph. A threshold graph takes it in
+// place, with its neighbors found on a grid, so a placement costs about the new station's
+// neighborhood; a k-nearest graph is rebuilt. A graph taken with sharedGraph() stays as it was for
+// as long as it is held, since placing copies a graph someone else holds before changing it; a
+// reference from currentGraph() lasts until the next place or rebuild.
+class PlacementSession {
+public:
+    PlacementSession(const std::string& state, const std::vector<Node>& nodes, const GraphOptions& options,
+                     double threshold);
+
+    // Places one station with the given id. placed is false if no two stations are connected.
+    Placement place(PlacementAlgorithm algorithm, int id);
+    // Same, calling assign to give the new station its id only once there is one to place, before
+    // the graph is rebuilt with it, so a placement that finds nothing uses up no id
+    Placement place(PlacementAlgorithm algorithm, const std::function<void(Node&)>& assign);
+    // Carries on from a station of this state placed before the session started, such as one
+    // restored from an earlier run, as if this session had placed it
+    void resume(int stationId);
+    // Source the single-source searches start from for the next placement, or -1 if no two
+    // stations are connected
+    int nextSource() const;
+
+    // A threshold within the built radius needs no rebuild
+    void setThreshold(double threshold) { this->threshold = threshold; }
+    void rebuild(const GraphOptions& options);
+
+    const std::string& state() const { return stateName; }
+    const StationGraph& currentGraph() const { return *current; }
+    std::shared_ptr<const StationGraph> sharedGraph() const { return current; }
+    // Threshold the searches use: the configured one, or the whole graph in k-nearest mode
+    double searchThreshold() const;
+    long long buildNs() const { return firstBuildNs; }
+
+private:
+    std::string stateName;
+    std::vector<Node> nodes;
+    GraphOptions options;
+    double threshold;
+    std::shared_ptr<StationGraph> current;
+    std::unique_ptr<SpatialGrid> grid;  // over current->nodes, made on the first placement
+    long long firstBuildNs = 0;
+    int lastPlaced = -1;
+    IncrementalSearch incremental;
+
+    // Lowest station id with an edge, or -1
+    int firstConnected() const;
+};
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_PLACEMENT_H
@@ -0,0 +1,80 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_RADIX_HEAP_H
+#define EV_CHARGING_STATION_OPTIMIZATION_RADIX_HEAP_H
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+// Monotone priority queue over unsigned integer keys: every pushed key must be >= the last
+// popped key, which always holds for Dijkstra with non-negative weights. Bucket i holds keys
+// whose highest bit differing from the last popped key is bit i - 1, so each element moves
+// to a lower bucket at most 64 times.
+template <typename T>
+class RadixHeap {
+public:
+    void push(uint64_t key, const T& value) {
+        buckets[bucketOf(key)].push_back({key, value});
+        count++;
+    }
+
+    // Removes and returns the entry with the smallest key
+    std::pair<uint64_t, T> pop() {
+        if (buckets[0].empty()) {
+            int i = 1;
+            while (buckets[i].empty()) {
+                i++;
+            }
+            uint64_t smallest = buckets[i][0].first;
+            for (const auto& entry : buckets[i]) {
+                if (entry.first < smallest) {
+                    smallest = entry.first;
+                }
+            }
+            last = smallest;
+            // everything in bucket i now differs from last in a lower bit
+            for (const auto& entry : buckets[i]) {
+                buckets[bucketOf(entry.first)].push_back(entry);
+            }
+            buckets[i].clear();
+        }
+        std::pair<uint64_t, T> top = buckets[0].back();
+        buckets[0].pop_back();
+        count--;
+        return top;
+    }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    void clear() {
+        for (auto& bucket : buckets) {
+            bucket.clear();
+        }
+        count = 0;
+        last = 0;
+    }
+
+private:
+    std::vector<std::pair<uint64_t, T>> buckets[65];
+    size_t count = 0;
+    uint64_t last = 0;
+
+    int bucketOf(uint64_t key) const {
+        uint64_t diff = key ^ last;
+        if (diff == 0) {
+            return 0;
+        }
+#if defined(__GNUC__)
+        return 64 - __builtin_clzll(diff);
+#else
+        int bit = 0;
+        while (diff != 0) {
+            diff >>= 1;
+            bit++;
+        }
+        return bit;
+#endif
+    }
+};
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_RADIX_HEAP_H
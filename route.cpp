@@ -0,0 +1,96 @@
+#include "route.h"
+#include "instrumentation.h"
+
+#include <limits>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+const double INF = numeric_limits<double>::infinity();
+}
+
+Route shortestRoute(const StationGraph& graph, int fromId, int toId, double threshold) {
+    return shortestRoute(graph, fromId, toId, threshold, localWorkspace(0), localWorkspace(1));
+}
+
+Route shortestRoute(const StationGraph& graph, int fromId, int toId, double threshold,
+                    SearchWorkspace& forward, SearchWorkspace& backward) {
+    ScopedTimer timer("route.bidirectional_astar");
+    Route route;
+    int s = graph.localIndex(fromId);
+    int t = graph.localIndex(toId);
+    if (s == -1 || t == -1) {
+        return route;
+    }
+    if (s == t) {
+        route.found = true;
+        route.path.push_back(fromId);
+        return route;
+    }
+
+    const Node& start = graph.nodes[s];
+    const Node& goal = graph.nodes[t];
+    // Forward potential; the reverse search uses its negation so both see the same reduced costs
+    auto potential = [&](int v) {
+        const Node& node = graph.nodes[v];
+        return (haversine(node.latitude, node.longitude, goal.latitude, goal.longitude) -
+                haversine(node.latitude, node.longitude, start.latitude, start.longitude)) / 2.0;
+    };
+
+    SearchWorkspace* search[2] = {&forward, &backward};
+    forward.begin(graph.size());
+    backward.begin(graph.size());
+    forward.setDistance(s, 0.0);
+    backward.setDistance(t, 0.0);
+    forward.push(potential(s), s);
+    backward.push(-potential(t), t);
+
+    double best = INF;
+    int meet = -1;
+    while (!forward.heapEmpty() && !backward.heapEmpty()) {
+        // Keys already include the potentials, so this is the usual bidirectional stop test
+        if (forward.heapTop() + backward.heapTop() >= best) {
+            break;
+        }
+        int side = forward.heapSize() <= backward.heapSize() ? 0 : 1;
+        SearchWorkspace& here = *search[side];
+        SearchWorkspace& there = *search[1 - side];
+        int u = here.pop().second;
+        if (here.visited(u)) {
+            continue;
+        }
+        here.markVisited(u);
+        route.settled++;
+
+        double du = here.distance(u);
+        int end = graph.prefixEnd(u, threshold);
+        for (int e = graph.offsets[u]; e < end; e++) {
+            int v = graph.targets[e];
+            double newDist = du + graph.weights[e];
+            if (newDist < here.distance(v)) {
+                here.setDistance(v, newDist, u);
+                here.push(newDist + (side == 0 ? potential(v) : -potential(v)), v);
+            }
+            double other = there.distance(v);
+            if (other < INF && here.distance(v) + other < best) {
+                best = here.distance(v) + other;
+                meet = v;
+            }
+        }
+    }
+
+    if (meet == -1) {
+        return route;
+    }
+    route.found = true;
+    route.distance = best;
+    for (int v = meet; v != -1; v = forward.parent(v)) {
+        route.path.push_back(graph.nodes[v].id);
+    }
+    reverse(route.path.begin(), route.path.end());
+    for (int v = backward.parent(meet); v != -1; v = backward.parent(v)) {
+        route.path.push_back(graph.nodes[v].id);
+    }
+    return route;
+}
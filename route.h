@@ -0,0 +1,25 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_ROUTE_H
+#define EV_CHARGING_STATION_OPTIMIZATION_ROUTE_H
+
+#include <vector>
+
+#include "graph.h"
+#include "search_workspace.h"
+
+// Shortest hop path between two stations
+struct Route {
+    bool found = false;
+    std::vector<int> path;  // station ids from the start to the goal
+    double distance = 0.0;  // km
+    int settled = 0;        // nodes settled by both searches together
+};
+
+// Bidirectional A* between two station ids using only edges of length <= threshold.
+// Straight-line (haversine) distance to the goal is a lower bound on any route, so both
+// searches use the average of the two directions' estimates as their potential and stop as
+// soon as their frontiers prove no shorter meeting point exists.
+Route shortestRoute(const StationGraph& graph, int fromId, int toId, double threshold);
+Route shortestRoute(const StationGraph& graph, int fromId, int toId, double threshold,
+                    SearchWorkspace& forward, SearchWorkspace& backward);
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_ROUTE_H
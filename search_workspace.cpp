@@ -0,0 +1,25 @@
+#include "search_workspace.h"
+
+using namespace std;
+
+void SearchWorkspace::begin(int n) {
+    // stamps from before a resize or a wraparound must never match a live version
+    if (version >= numeric_limits<uint32_t>::max() - 3) {
+        for (Slot& slot : slots) {
+            slot.stamp = 0;
+        }
+        version = 0;
+    }
+    version += 2;
+    if (static_cast<int>(slots.size()) < n) {
+        slots.resize(n, Slot{0.0, -1, 0});
+    }
+    heap.clear();
+    radix.clear();
+    touchedCount = 0;
+}
+
+SearchWorkspace& localWorkspace(int slot) {
+    thread_local SearchWorkspace workspaces[2];
+    return workspaces[slot];
+}
@@ -0,0 +1,80 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_SEARCH_WORKSPACE_H
+#define EV_CHARGING_STATION_OPTIMIZATION_SEARCH_WORKSPACE_H
+
+#include <vector>
+#include <utility>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+
+#include "radix_heap.h"
+
+// Scratch space for one shortest-path search at a time: distance, parent and visited state per
+// node plus heap storage, kept between queries. Each node's entry carries the version of the
+// query that last wrote it, so starting a new query only bumps the version instead of refilling
+// arrays sized to the graph; entries from older versions read as unreached.
+class SearchWorkspace {
+public:
+    // Starts a new query over a graph with n nodes
+    void begin(int n);
+
+    double distance(int u) const {
+        return current(u) ? slots[u].dist : std::numeric_limits<double>::infinity();
+    }
+    int parent(int u) const { return current(u) ? slots[u].parent : -1; }
+    bool visited(int u) const { return slots[u].stamp == version + 1; }
+
+    void setDistance(int u, double dist, int parent = -1) {
+        Slot& slot = slots[u];
+        if (slot.stamp - version > 1) {
+            slot.stamp = version;
+            touchedCount++;
+        }
+        slot.dist = dist;
+        slot.parent = parent;
+    }
+    // Only reached nodes can be visited
+    void markVisited(int u) { slots[u].stamp = version + 1; }
+    // Nodes given a distance since begin()
+    int touched() const { return touchedCount; }
+
+    // Binary min-heap of (key, node) in storage that keeps its capacity between queries
+    void push(double key, int u) {
+        heap.push_back({key, u});
+        std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<double, int>>());
+    }
+    std::pair<double, int> pop() {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<double, int>>());
+        std::pair<double, int> top = heap.back();
+        heap.pop_back();
+        return top;
+    }
+    bool heapEmpty() const { return heap.empty(); }
+    size_t heapSize() const { return heap.size(); }
+    double heapTop() const { return heap.front().first; }
+
+    // Integer-keyed heap for searches over quantized distances, emptied by begin()
+    RadixHeap<int> radix;
+
+private:
+    // One cache line holds four nodes' entries. A node is current when its stamp is version,
+    // and also visited when it is version + 1; versions advance in steps of two.
+    struct Slot {
+        double dist;
+        int parent;
+        uint32_t stamp;
+    };
+    std::vector<Slot> slots;
+    std::vector<std::pair<double, int>> heap;
+    uint32_t version = 0;
+    int touchedCount = 0;
+
+    bool current(int u) const { return slots[u].stamp - version <= 1; }
+};
+
+// Workspaces owned by the calling thread, for searches that are not handed one explicitly.
+// Bidirectional searches use slots 0 and 1.
+SearchWorkspace& localWorkspace(int slot = 0);
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_SEARCH_WORKSPACE_H
@@ -0,0 +1,798 @@
+#include "server.h"
+
+#include <iostream>
+
+#ifndef _WIN32
+
+#include "graph.h"
+#include "ingest.h"
+#include "placement.h"
+#include "shortest_paths.h"
+#include "diameter.h"
+#include "route.h"
+#include "spatial_index.h"
+#include "json.h"
+#include "instrumentation.h"
+#include "parallel.h"
+#include "task_pool.h"
+#include "journal.h"
+
+#include <sstream>
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+// Same as the menu program: chargers within 25 m of each other are one site
+const double COLLAPSE_EPSILON_KM = 0.025;
+// Latencies kept per operation for the percentiles in stats
+const size_t RECENT_LATENCIES = 4096;
+const int MAX_NEAREST = 100;
+// Fields read as numbers; sent as strings they are a mistake in the request
+const char* const NUMBER_FIELDS[] = {"from", "to", "k", "latitude", "longitude"};
+// Longest a placement waits in the journal's buffer before it is written and synced
+const int JOURNAL_FLUSH_MS = 50;
+
+// Written to by the SIGTERM and SIGINT handler, which can do little else safely
+int signalPipe = -1;
+
+void onTerminate(int) {
+    int saved = errno;
+    char stop = 's';
+    ssize_t written = write(signalPipe, &stop, 1);
+    (void) written;
+    errno = saved;
+}
+
+typedef map<string, string> Fields;
+
+long long nanosecondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+}
+
+struct ServerOptions {
+    string socketPath = DEFAULT_SOCKET;
+    string dataPath = "../data/openchargemap_data.csv";
+    GraphOptions graph;
+    double threshold = 2.0;
+};
+
+// One version of a state's graph as queries see it. Never changed once published: a placement
+// publishes a new one, and the writer frees the old one once no query is reading it, so a
+// query never pays for freeing a graph it happened to hold last.
+struct StateSnapshot {
+    long long version = 0;               // placements made before it
+    string state;
+    shared_ptr<const StationGraph> graph;
+    double threshold = 0.0;              // what searches on it use
+    unique_ptr<SpatialGrid> grid;        // over graph->nodes
+};
+
+// One state's stations, and once a request has needed them, its graph
+struct StateGraph {
+    vector<Node> stations;
+    mutex writer;                          // one placement, or the first build, at a time
+    unique_ptr<PlacementSession> session;  // only touched by the writer
+    // Read and replaced with atomic_load and atomic_store, so queries never wait for the writer.
+    // In C++14 those are not lock-free: libstdc++ guards each with a mutex from a small pool picked
+    // by address, held just long enough to copy the pointer, so concurrent loads do briefly contend.
+    shared_ptr<const StateSnapshot> current;
+    // Snapshots replaced by a newer one that queries may still be reading; only touched by the writer
+    vector<shared_ptr<const StateSnapshot>> retired;
+    int lastRestored = -1;  // the last station placed here in an earlier run, where placing carries on
+};
+
+// Latencies of one kind of request
+struct OperationStats {
+    long long count = 0;
+    long long errors = 0;
+    long long totalNs = 0;
+    long long maxNs = 0;
+    vector<long long> recent;  // the last RECENT_LATENCIES, as a ring
+    size_t next = 0;
+};
+
+class Connection {
+public:
+    explicit Connection(int fd) : fd(fd) {}
+    ~Connection() { close(fd); }
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    int descriptor() const { return fd; }
+
+    // Writes one response line; lines written from different threads never interleave
+    void send(const string& line) {
+        lock_guard<mutex> lock(writeMutex);
+        size_t written = 0;
+        while (written < line.size()) {
+            ssize_t n = write(fd, line.data() + written, line.size() - written);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return;  // the client went away
+            }
+            written += n;
+        }
+    }
+
+private:
+    int fd;
+    mutex writeMutex;
+};
+
+// Value of a field as a number, or false with error set if it is missing or not one
+bool intField(const Fields& fields, const string& key, int& value, string& error) {
+    auto it = fields.find(key);
+    try {
+        size_t used = 0;
+        if (it != fields.end()) {
+            value = stoi(it->second, &used);
+            if (used == it->second.size()) {
+                return true;
+            }
+        }
+    } catch (const logic_error&) {
+    }
+    error = "expected a whole number in " + key;
+    return false;
+}
+
+bool numberField(const Fields& fields, const string& key, double& value, string& error) {
+    auto it = fields.find(key);
+    try {
+        size_t used = 0;
+        if (it != fields.end()) {
+            value = stod(it->second, &used);
+            // stod also takes nan and inf, which a JSON number can't be
+            if (used == it->second.size() && isfinite(value)) {
+                return true;
+            }
+        }
+    } catch (const logic_error&) {
+    }
+    error = "expected a number in " + key;
+    return false;
+}
+
+// The request's id as it goes back in the response: a string id as a string, and numbers, true,
+// false and null as sent (parseFlatObject has checked they are valid JSON)
+string echoId(const Fields& fields, const set<string>& quoted) {
+    auto it = fields.find("id");
+    if (it == fields.end()) {
+        return "null";
+    }
+    return quoted.count("id") ? jsonQuote(it->second) : it->second;
+}
+
+class Server {
+public:
+    // nodes and loaded are as PlacementJournal::load left them, the stations placed in earlier runs last
+    Server(const ServerOptions& options, const vector<Node>& nodes, const JournalLoad& loaded,
+           PlacementJournal& journal);
+    // Listens until a shutdown request, then finishes the requests already received
+    int run();
+
+private:
+    ServerOptions options;
+    int stationCount;
+    map<string, unique_ptr<StateGraph>> states;  // every state with stations, fixed after loading
+    // Ids are taken and journaled together, only by placements that found a spot, so ids have no
+    // gaps and the journal has them in order whichever state finishes first
+    mutex placedMutex;
+    int nextId;                                  // guarded by placedMutex
+    PlacementJournal& journal;                   // where placements are kept across restarts
+    // The scheduler every parallel stage runs on, so requests and the searches inside them share
+    // one set of workerCount() - 1 threads, with the accepting thread as the last one
+    TaskPool& pool;
+
+    mutex statsMutex;
+    map<string, OperationStats> stats;
+
+    int listenFd = -1;
+    int wakePipe[2] = {-1, -1};  // 's' from a signal stops the server, 'q' ends housekeeping
+    atomic<bool> stopping;
+    mutex connectionsMutex;
+    condition_variable readersDone;
+    vector<weak_ptr<Connection>> connections;
+    int readers = 0;
+
+    void readLoop(shared_ptr<Connection> connection);
+    // Flushes the journal every JOURNAL_FLUSH_MS and stops the server on SIGTERM or SIGINT
+    void housekeeping();
+    void handle(const shared_ptr<Connection>& connection, const string& line,
+                chrono::steady_clock::time_point arrival);
+    void record(const string& op, long long latencyNs, bool ok);
+    void stop();
+
+    // The request's state, or nullptr with error set
+    StateGraph* findState(const Fields& fields, string& error);
+    // The state's latest snapshot, building its graph first if no request has needed it yet
+    shared_ptr<const StateSnapshot> snapshot(StateGraph& state);
+    // Makes the session's graph the state's latest snapshot and frees replaced ones no query still
+    // reads; the caller holds the writer lock
+    void publish(StateGraph& state, long long version);
+
+    // Each answers one operation, writing its result fields to out
+    bool farthest(const Fields& fields, ostream& out, string& error);
+    bool place(const Fields& fields, ostream& out, string& error);
+    bool nearest(const Fields& fields, ostream& out, string& error);
+    bool route(const Fields& fields, ostream& out, string& error);
+    void writeStats(ostream& out);
+};
+
+Server::Server(const ServerOptions& options, const vector<Node>& nodes, const JournalLoad& loaded,
+               PlacementJournal& journal)
+        : options(options), stationCount(nodes.size()), nextId(loaded.nextId), journal(journal),
+          pool(scheduler()), stopping(false) {
+    for (size_t i = 0; i < nodes.size(); i++) {
+        unique_ptr<StateGraph>& state = states[nodes[i].stateOrProvince];
+        if (!state) {
+            state.reset(new StateGraph());
+        }
+        state->stations.push_back(nodes[i]);
+        if (i >= nodes.size() - loaded.placed) {
+            state->lastRestored = nodes[i].id;
+        }
+    }
+}
+
+StateGraph* Server::findState(const Fields& fields, string& error) {
+    auto field = fields.find("state");
+    string abbreviation = field == fields.end() ? string() : stateAbbreviation(field->second);
+    auto it = states.find(abbreviation);
+    if (it == states.end()) {
+        error = field == fields.end() ? "missing state" : "no stations in " + field->second;
+        return nullptr;
+    }
+    return it->second.get();
+}
+
+shared_ptr<const StateSnapshot> Server::snapshot(StateGraph& state) {
+    shared_ptr<const StateSnapshot> latest = atomic_load(&state.current);
+    if (latest) {
+        return latest;
+    }
+    // the first request for a state builds its graph; any others that arrive meanwhile wait for it
+    lock_guard<mutex> lock(state.writer);
+    if (!state.session) {
+        GraphOptions graphOptions = options.graph;
+        graphOptions.maxRadius = options.threshold;
+        state.session.reset(new PlacementSession(state.stations.front().stateOrProvince, state.stations,
+                                                 graphOptions, options.threshold));
+        if (state.lastRestored != -1) {
+            state.session->resume(state.lastRestored);
+        }
+        publish(state, 0);
+    }
+    return atomic_load(&state.current);
+}
+
+void Server::publish(StateGraph& state, long long version) {
+    shared_ptr<StateSnapshot> next = make_shared<StateSnapshot>();
+    next->version = version;
+    next->state = state.session->state();
+    next->graph = state.session->sharedGraph();
+    next->threshold = state.session->searchThreshold();
+    next->grid.reset(new SpatialGrid(next->graph->nodes));
+    shared_ptr<const StateSnapshot> previous =
+            atomic_exchange(&state.current, shared_ptr<const StateSnapshot>(move(next)));
+    if (previous) {
+        state.retired.push_back(move(previous));
+    }
+    // a retired snapshot only held here can't be picked up again, since current no longer points
+    // to it, so it is freed now rather than by whichever query happens to drop it last
+    state.retired.erase(remove_if(state.retired.begin(), state.retired.end(),
+                                  [](const shared_ptr<const StateSnapshot>& old) { return old.use_count() == 1; }),
+                        state.retired.end());
+}
+
+bool Server::farthest(const Fields& fields, ostream& out, string& error) {
+    PlacementAlgorithm algorithm = PlacementAlgorithm::Dijkstra;
+    auto name = fields.find("algorithm");
+    if (name != fields.end() && !parsePlacementAlgorithm(name->second, algorithm)) {
+        error = "unknown algorithm " + name->second;
+        return false;
+    }
+    if (algorithm == PlacementAlgorithm::IncrementalDijkstra) {
+        error = "incremental is only used for placements";
+        return false;
+    }
+    StateGraph* state = findState(fields, error);
+    if (state == nullptr) {
+        return false;
+    }
+    shared_ptr<const StateSnapshot> view = snapshot(*state);
+    const StationGraph& graph = *view->graph;
+    double active = view->threshold;
+
+    auto start = chrono::steady_clock::now();
+    int from = -1;
+    pair<int, double> result;
+    if (algorithm == PlacementAlgorithm::FarthestPair) {
+        // the farthest pair of the whole state, so no starting station
+        FarthestPair best = graphDiameter(graph, active);
+        from = best.from;
+        result = {best.to, best.distance};
+    } else {
+        if (!intField(fields, "from", from, error)) {
+            return false;
+        }
+        if (!graph.contains(from)) {
+            error = "station " + to_string(from) + " is not in " + view->state;
+            return false;
+        }
+        if (algorithm == PlacementAlgorithm::Dijkstra) {
+            result = dijkstra_alg(from, graph, active);
+        } else if (algorithm == PlacementAlgorithm::BellmanFord) {
+            result = bellman_ford(from, graph, active);
+        } else if (algorithm == PlacementAlgorithm::RadixDijkstra) {
+            result = dijkstra_radix(from, graph, active);
+        } else {
+            result = bellman_ford_parallel(from, graph, active);
+        }
+    }
+    out << ", \"version\": " << view->version << ", \"from\": " << from << ", \"farthest\": " << result.first
+        << ", \"distance_km\": " << result.second << ", \"search_ns\": " << nanosecondsSince(start);
+    return true;
+}
+
+bool Server::place(const Fields& fields, ostream& out, string& error) {
+    PlacementAlgorithm algorithm = PlacementAlgorithm::Dijkstra;
+    auto name = fields.find("algorithm");
+    if (name != fields.end() && !parsePlacementAlgorithm(name->second, algorithm)) {
+        error = "unknown algorithm " + name->second;
+        return false;
+    }
+    StateGraph* state = findState(fields, error);
+    if (state == nullptr) {
+        return false;
+    }
+    snapshot(*state);  // builds the graph if this is the state's first request
+    // placements in a state take turns; queries keep reading the last published version while
+    // the next one is built, and see the new station once it is swapped in
+    lock_guard<mutex> lock(state->writer);
+    Placement placement = state->session->place(algorithm, [this](Node& station) {
+        lock_guard<mutex> placedLock(placedMutex);
+        station.id = nextId++;
+        journal.append(station);
+    });
+    if (!placement.placed) {
+        error = "no two stations are connected";
+        return false;
+    }
+    long long version = atomic_load(&state->current)->version + 1;
+    publish(*state, version);
+    out << ", \"version\": " << version << ", \"station\": {\"id\": " << placement.station.id << ", \"latitude\": " << placement.station.latitude
+        << ", \"longitude\": " << placement.station.longitude << "}, \"source\": " << placement.sourceId
+        << ", \"farthest\": " << placement.farthestId << ", \"distance_km\": " << placement.distance
+        << ", \"search_ns\": " << placement.searchNs << ", \"rebuild_ns\": " << placement.rebuildNs
+        << ", \"stations\": " << state->session->currentGraph().size();
+    return true;
+}
+
+bool Server::nearest(const Fields& fields, ostream& out, string& error) {
+    double latitude = 0.0;
+    double longitude = 0.0;
+    int k = 1;
+    if (!numberField(fields, "latitude", latitude, error) || !numberField(fields, "longitude", longitude, error) ||
+        (fields.count("k") && !intField(fields, "k", k, error))) {
+        return false;
+    }
+    if (k < 1 || k > MAX_NEAREST) {
+        error = "k must be between 1 and " + to_string(MAX_NEAREST);
+        return false;
+    }
+    if (latitude < -90.0 || latitude > 90.0 || longitude < -180.0 || longitude > 180.0) {
+        error = "latitude must be between -90 and 90 and longitude between -180 and 180";
+        return false;
+    }
+    StateGraph* state = findState(fields, error);
+    if (state == nullptr) {
+        return false;
+    }
+    shared_ptr<const StateSnapshot> view = snapshot(*state);
+    const StationGraph& graph = *view->graph;
+    vector<pair<double, int>> found = view->grid->nearest(latitude, longitude, k);
+    out << ", \"version\": " << view->version << ", \"stations\": [";
+    for (size_t i = 0; i < found.size(); i++) {
+        const Node& station = graph.nodes[found[i].second];
+        out << (i == 0 ? "" : ", ") << "{\"id\": " << station.id << ", \"latitude\": " << station.latitude
+            << ", \"longitude\": " << station.longitude << ", \"distance_km\": " << found[i].first << "}";
+    }
+    out << "]";
+    return true;
+}
+
+bool Server::route(const Fields& fields, ostream& out, string& error) {
+    int from = -1;
+    int to = -1;
+    if (!intField(fields, "from", from, error) || !intField(fields, "to", to, error)) {
+        return false;
+    }
+    StateGraph* state = findState(fields, error);
+    if (state == nullptr) {
+        return false;
+    }
+    shared_ptr<const StateSnapshot> view = snapshot(*state);
+    const StationGraph& graph = *view->graph;
+    for (int id : {from, to}) {
+        if (!graph.contains(id)) {
+            error = "station " + to_string(id) + " is not in " + view->state;
+            return false;
+        }
+    }
+    auto start = chrono::steady_clock::now();
+    Route found = shortestRoute(graph, from, to, view->threshold);
+    out << ", \"version\": " << view->version << ", \"found\": " << (found.found ? "true" : "false") << ", \"distance_km\": " << found.distance
+        << ", \"path\": [";
+    for (size_t i = 0; i < found.path.size(); i++) {
+        out << (i == 0 ? "" : ", ") << found.path[i];
+    }
+    out << "], \"settled\": " << found.settled << ", \"search_ns\": " << nanosecondsSince(start);
+    return true;
+}
+
+void Server::writeStats(ostream& out) {
+    int built = 0;
+    for (auto& state : states) {
+        built += atomic_load(&state.second->current) ? 1 : 0;
+    }
+    out << ", \"stations\": " << stationCount << ", \"states\": " << states.size() << ", \"states_built\": "
+        << built << ", \"threads\": " << max(1, pool.size()) << ", \"operations\": {";
+    lock_guard<mutex> lock(statsMutex);
+    bool first = true;
+    for (const auto& entry : stats) {
+        const OperationStats& op = entry.second;
+        vector<long long> sorted = op.recent;
+        sort(sorted.begin(), sorted.end());
+        // nearest-rank percentiles over the recent requests
+        auto percentile = [&sorted](double p) {
+            size_t rank = static_cast<size_t>(p * sorted.size() + 0.999999);
+            return sorted.empty() ? 0LL : sorted[min(sorted.size(), max<size_t>(rank, 1)) - 1];
+        };
+        out << (first ? "" : ", ") << jsonQuote(entry.first) << ": {\"count\": " << op.count
+            << ", \"errors\": " << op.errors << ", \"mean_ns\": " << (op.count ? op.totalNs / op.count : 0)
+            << ", \"p50_ns\": " << percentile(0.5) << ", \"p99_ns\": " << percentile(0.99)
+            << ", \"max_ns\": " << op.maxNs << "}";
+        first = false;
+    }
+    out << "}";
+    if (instrumentationEnabled()) {
+        out << ", \"instrumentation\": ";
+        writeInstrumentationJSON(out);
+    }
+}
+
+void Server::record(const string& op, long long latencyNs, bool ok) {
+    lock_guard<mutex> lock(statsMutex);
+    OperationStats& entry = stats[op];
+    entry.count++;
+    entry.errors += ok ? 0 : 1;
+    entry.totalNs += latencyNs;
+    entry.maxNs = max(entry.maxNs, latencyNs);
+    if (entry.recent.size() < RECENT_LATENCIES) {
+        entry.recent.push_back(latencyNs);
+    } else {
+        entry.recent[entry.next] = latencyNs;
+        entry.next = (entry.next + 1) % RECENT_LATENCIES;
+    }
+}
+
+void Server::handle(const shared_ptr<Connection>& connection, const string& line,
+                    chrono::steady_clock::time_point arrival) {
+    long long queueNs = nanosecondsSince(arrival);
+    Fields fields;
+    set<string> quoted;
+    string error;
+    string op = "invalid";
+    ostringstream result;
+    result.precision(10);
+    bool ok = parseFlatObject(line, fields, error, &quoted);
+    if (ok) {
+        auto it = fields.find("op");
+        op = it == fields.end() ? "invalid" : it->second;
+        TraceScope trace("server.request", op);
+        string quotedNumber;
+        for (const char* key : NUMBER_FIELDS) {
+            if (quoted.count(key)) {
+                quotedNumber = key;
+            }
+        }
+        if (!quotedNumber.empty() && (op == "farthest" || op == "nearest" || op == "route")) {
+            error = "expected a number in " + quotedNumber;
+            ok = false;
+        } else if (op == "farthest") {
+            ok = farthest(fields, result, error);
+        } else if (op == "place") {
+            ok = place(fields, result, error);
+        } else if (op == "nearest") {
+            ok = nearest(fields, result, error);
+        } else if (op == "route") {
+            ok = route(fields, result, error);
+        } else if (op == "stats") {
+            writeStats(result);
+        } else if (op == "shutdown") {
+            stopping = true;
+        } else {
+            error = it == fields.end() ? "missing op" : "unknown op " + op;
+            op = "invalid";
+            ok = false;
+        }
+    }
+    long long latencyNs = nanosecondsSince(arrival);
+    record(op, latencyNs, ok);
+
+    ostringstream response;
+    response << "{\"id\": " << echoId(fields, quoted) << ", \"op\": " << jsonQuote(op) << ", \"ok\": "
+             << (ok ? "true" : "false");
+    if (ok) {
+        response << result.str();
+    } else {
+        response << ", \"error\": " << jsonQuote(error);
+    }
+    response << ", \"queue_ns\": " << queueNs << ", \"latency_ns\": " << latencyNs << "}\n";
+    connection->send(response.str());
+    if (op == "shutdown") {
+        stop();
+    }
+}
+
+void Server::readLoop(shared_ptr<Connection> connection) {
+    string pending;
+    char buffer[4096];
+    while (true) {
+        ssize_t n = read(connection->descriptor(), buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        auto arrival = chrono::steady_clock::now();
+        pending.append(buffer, n);
+        size_t start = 0;
+        size_t end;
+        while ((end = pending.find('\n', start)) != string::npos) {
+            string line = pending.substr(start, end - start);
+            start = end + 1;
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.find_first_not_of(" \t") == string::npos) {
+                continue;
+            }
+            if (pool.size() == 0) {
+                // with --threads 1 the scheduler has no threads of its own, so the reader answers
+                handle(connection, line, arrival);
+            } else {
+                pool.submit([this, connection, line, arrival] { handle(connection, line, arrival); });
+            }
+        }
+        pending.erase(0, start);
+    }
+    lock_guard<mutex> lock(connectionsMutex);
+    readers--;
+    readersDone.notify_all();
+}
+
+void Server::stop() {
+    // wakes the accept in run(), which then stops every connection from reading
+    shutdown(listenFd, SHUT_RDWR);
+}
+
+void Server::housekeeping() {
+    pollfd wake = {wakePipe[0], POLLIN, 0};
+    bool failing = false;
+    while (true) {
+        int ready = poll(&wake, 1, JOURNAL_FLUSH_MS);
+        // placements are answered before they are synced; this bounds how long they go unsynced
+        bool flushed = journal.flush();
+        // said once when writing starts failing and once when it works again, not every round
+        if (flushed == failing) {
+            failing = !flushed;
+            cerr << (failing ? "Error: Could not write " : "Writing again to ") << journal.journalPath()
+                 << (failing ? "; placements are kept and retried" : "") << endl;
+        }
+        char reason;
+        if (ready <= 0 || read(wakePipe[0], &reason, 1) != 1) {
+            continue;
+        }
+        if (reason == 'q') {
+            return;
+        }
+        cerr << "Stopping on signal" << endl;
+        stopping = true;
+        stop();
+    }
+}
+
+int Server::run() {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (options.socketPath.size() >= sizeof(address.sun_path)) {
+        cerr << "Socket path is too long: " << options.socketPath << endl;
+        return 1;
+    }
+    strncpy(address.sun_path, options.socketPath.c_str(), sizeof(address.sun_path) - 1);
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    // a socket file left by a server that was killed would make bind fail
+    unlink(options.socketPath.c_str());
+    if (listenFd < 0 || bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listenFd, SOMAXCONN) != 0) {
+        cerr << "Error: Could not listen on " << options.socketPath << ": " << strerror(errno) << endl;
+        return 1;
+    }
+    cerr << "Serving " << stationCount << " stations in " << states.size() << " states on "
+         << options.socketPath << " with " << max(1, pool.size()) << " threads" << endl;
+
+    // SIGTERM and SIGINT stop the server like a shutdown request, so placements are all written
+    if (pipe(wakePipe) != 0) {
+        cerr << "Error: Could not create a pipe: " << strerror(errno) << endl;
+        close(listenFd);
+        unlink(options.socketPath.c_str());
+        return 1;
+    }
+    signalPipe = wakePipe[1];
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onTerminate;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGTERM, &action, nullptr);
+    sigaction(SIGINT, &action, nullptr);
+    thread housekeeper(&Server::housekeeping, this);
+
+    while (!stopping) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+        auto connection = make_shared<Connection>(fd);
+        lock_guard<mutex> lock(connectionsMutex);
+        connections.erase(remove_if(connections.begin(), connections.end(),
+                                    [](const weak_ptr<Connection>& c) { return c.expired(); }),
+                          connections.end());
+        connections.push_back(connection);
+        readers++;
+        thread(&Server::readLoop, this, connection).detach();
+    }
+
+    // take no more requests, answer the ones already read, then let the connections close
+    {
+        unique_lock<mutex> lock(connectionsMutex);
+        for (const auto& weak : connections) {
+            if (shared_ptr<Connection> connection = weak.lock()) {
+                shutdown(connection->descriptor(), SHUT_RD);
+            }
+        }
+        readersDone.wait(lock, [this] { return readers == 0; });
+    }
+    pool.wait();
+    close(listenFd);
+    unlink(options.socketPath.c_str());
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGINT, SIG_DFL);
+    char quit = 'q';
+    if (write(wakePipe[1], &quit, 1) == 1) {
+        housekeeper.join();
+    } else {
+        housekeeper.detach();
+    }
+    signalPipe = -1;
+    close(wakePipe[0]);
+    close(wakePipe[1]);
+    if (!journal.flush()) {
+        cerr << "Error: Could not write the last placements to " << journal.journalPath() << endl;
+    }
+
+    ostringstream summary;
+    writeStats(summary);
+    cerr << "Stopped. Totals: {" << summary.str().substr(2) << "}" << endl;
+    return 0;
+}
+
+bool parseArguments(const vector<string>& arguments, ServerOptions& options) {
+    for (size_t i = 0; i < arguments.size(); i++) {
+        const string& flag = arguments[i];
+        if (flag == "--serve") {
+            // the socket path is optional
+            if (i + 1 < arguments.size() && arguments[i + 1].compare(0, 2, "--") != 0) {
+                options.socketPath = arguments[++i];
+            }
+            continue;
+        }
+        if (i + 1 >= arguments.size()) {
+            cerr << "Missing value for " << flag << endl;
+            return false;
+        }
+        const string& value = arguments[++i];
+        try {
+            if (flag == "--data") {
+                options.dataPath = value;
+            } else if (flag == "--threshold") {
+                options.threshold = stod(value);
+            } else if (flag == "--k") {
+                options.graph.k = stoi(value);
+            } else if (flag == "--mode" && (value == "threshold" || value == "knn")) {
+                options.graph.mode = value == "knn" ? GraphMode::KNearest : GraphMode::Threshold;
+            } else {
+                cerr << "Unknown option " << flag << " " << value << endl;
+                return false;
+            }
+        } catch (const logic_error&) {
+            cerr << "Invalid value for " << flag << ": " << value << endl;
+            return false;
+        }
+    }
+    if (!(options.threshold > 0.0) || !isfinite(options.threshold) || options.graph.k < 1) {
+        cerr << "threshold must be a finite distance greater than 0 km and k at least 1" << endl;
+        return false;
+    }
+    return true;
+}
+}
+
+int runServer(const vector<string>& arguments) {
+    ServerOptions options;
+    if (!parseArguments(arguments, options)) {
+        return 2;
+    }
+    // a client closing its connection early must not end the server
+    signal(SIGPIPE, SIG_IGN);
+    vector<Node> nodes;
+    // placements are journaled in batches, or every JOURNAL_FLUSH_MS when fewer come in, and
+    // whatever is left is written when the server stops
+    PlacementJournal journal(options.dataPath);
+    JournalLoad loaded = journal.load(nodes, COLLAPSE_EPSILON_KM);
+    if (!loaded.loaded) {
+        if (loaded.inUse) {
+            cerr << "Error: " << journal.journalPath() << " is in use by another program" << endl;
+            return 1;
+        }
+        cerr << "Error: Could not open file " << options.dataPath << endl;
+        return 1;
+    }
+    if (loaded.placed > 0) {
+        cerr << "Restored " << loaded.placed << " stations placed in earlier runs" << endl;
+    }
+    int status;
+    {
+        Server server(options, nodes, loaded, journal);
+        vector<Node>().swap(nodes);
+        status = server.run();
+    }
+    return status;
+}
+
+#else
+
+int runServer(const std::vector<std::string>&) {
+    std::cerr << "The server needs Unix domain sockets, which this system does not have" << std::endl;
+    return 1;
+}
+
+#endif
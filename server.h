@@ -0,0 +1,36 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_SERVER_H
+#define EV_CHARGING_STATION_OPTIMIZATION_SERVER_H
+
+#include <string>
+#include <vector>
+
+// Socket the server listens on and the client connects to when none is given
+const char* const DEFAULT_SOCKET = "ev_stations.sock";
+
+// Long-running query mode, on systems with Unix domain sockets. arguments are the command line
+// after the program name:
+//   --serve [SOCKET] [--data FILE] [--threshold KM] [--mode threshold|knn] [--k N]
+// Loads the data file once and answers requests sent to SOCKET, one JSON object per line, with
+// one JSON line each. Requests from every connection run at the same time on the scheduler
+// every parallel stage uses (see parallel.h), so a request's own parallel searches share its
+// workerCount() - 1 threads instead of adding more; with one thread in all, each connection's
+// requests run on the thread reading it. Responses come back in the order they finish and echo
+// the request's "id":
+//   {"id": 1, "op": "farthest", "state": "CA", "from": 12, "algorithm": "dijkstra"}
+//   {"id": 2, "op": "place", "state": "CA", "algorithm": "radix"}
+//   {"id": 3, "op": "nearest", "state": "CA", "latitude": 34.05, "longitude": -118.25, "k": 3}
+//   {"id": 4, "op": "route", "state": "CA", "from": 12, "to": 40}
+//   {"id": 5, "op": "stats"}
+//   {"id": 6, "op": "shutdown"}
+// A state's graph is built by its first request and kept for the rest. Queries read an immutable
+// snapshot of it, so they never wait for a placement: each placement publishes the next version,
+// which queries report as "version", the number of stations placed in that state since the server
+// started. Placements go to the data file's journal (see journal.h), so they are there after a
+// restart. A placement is answered before it is synced, and synced within 50 ms; SIGTERM and
+// SIGINT stop the server like a shutdown request, syncing the rest, so only a crash or kill -9 in
+// that window loses an acknowledged placement. Every response has "latency_ns", from the request
+// arriving to its response being ready, and "queue_ns", the part of that spent waiting for a
+// thread; stats returns both per operation. Returns the exit code.
+int runServer(const std::vector<std::string>& arguments);
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_SERVER_H
@@ -0,0 +1,406 @@
+#include "shortest_paths.h"
+
+#include <vector>
+#include <queue>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <mutex>
+
+#include "radix_heap.h"
+#include "parallel.h"
+#include "instrumentation.h"
+
+using namespace std;
+
+//Djikstr'a Alg
+//only edges of length <= threshold are used, which is a prefix of every adjacency list
+pair<int, double> dijkstra_alg(int Id, const StationGraph& graph, double threshold) {
+    return dijkstra_alg(Id, graph, threshold, localWorkspace());
+}
+
+pair<int, double> dijkstra_alg(int Id, const StationGraph& graph, double threshold, SearchWorkspace& workspace) {
+    ScopedTimer timer("search.dijkstra_alg");
+    workspace.begin(graph.size());
+    int source = graph.localIndex(Id);
+    workspace.setDistance(source, 0.0);
+    workspace.push(0.0, source);
+    // nodes settle in distance order, so the farthest is tracked on the way instead of scanning
+    // every node afterwards; ties go to the lowest local index like the scan did
+    int farthest = -1;
+    double maxDistance = 0.0;
+    long long pushes = 1;
+    long long stalePops = 0;
+    long long relaxations = 0;
+    while (!workspace.heapEmpty()) {
+        pair<double, int> top = workspace.pop();
+        double currDist = top.first;
+        int currNode = top.second;
+        if (currDist > workspace.distance(currNode)) {
+            stalePops++;
+        } else {
+            if (currDist > maxDistance || (currDist == maxDistance && farthest != -1 && currNode < farthest)) {
+                maxDistance = currDist;
+                farthest = currNode;
+            }
+            int end = graph.prefixEnd(currNode, threshold);
+            relaxations += end - graph.offsets[currNode];
+            for (int e = graph.offsets[currNode]; e < end; ++e) {
+                int neighbor = graph.targets[e];
+                double weight = graph.weights[e];
+                double newDist = currDist + weight;
+
+                if (newDist < workspace.distance(neighbor)) {
+                    workspace.setDistance(neighbor, newDist);
+                    workspace.push(newDist, neighbor);
+                    pushes++;
+                }
+            }
+        }
+    }
+    if (instrumentationEnabled()) {
+        recordCount("dijkstra_alg.heap_pushes", pushes);
+        recordCount("dijkstra_alg.stale_pops", stalePops);
+        recordCount("dijkstra_alg.relaxations", relaxations);
+    }
+    int farthestNodeId = farthest == -1 ? -1 : graph.nodes[farthest].id;
+
+    return {farthestNodeId, maxDistance};
+}
+
+pair<int, double> bellman_ford(int ID, const StationGraph& graph, double threshold) {
+    return bellman_ford(ID, graph, threshold, localWorkspace());
+}
+
+pair<int, double> bellman_ford(int ID, const StationGraph& graph, double threshold, SearchWorkspace& workspace) {
+    ScopedTimer timer("search.bellman_ford");
+    int size = graph.size();
+    long long rounds = 0;
+    long long relaxations = 0;
+
+    // Every distance starts out as infinity
+    workspace.begin(size);
+    workspace.setDistance(graph.localIndex(ID), 0.0);
+
+    for (int i = 0; i < size - 1; i++) {
+        bool updated = false;
+        rounds++;
+        for (int currentNode = 0; currentNode < size; currentNode++) {
+            double currentDistance = workspace.distance(currentNode);
+            if (currentDistance == numeric_limits<double>::infinity()) {
+                continue;
+            }
+            int end = graph.prefixEnd(currentNode, threshold);
+            relaxations += end - graph.offsets[currentNode];
+            for (int e = graph.offsets[currentNode]; e < end; e++) {
+                int neighborID = graph.targets[e];
+                double edgeWeight = graph.weights[e];
+                if (currentDistance + edgeWeight < workspace.distance(neighborID)) {
+                    workspace.setDistance(neighborID, currentDistance + edgeWeight);
+                    updated = true;
+                }
+            }
+        }
+        if (!updated) {
+            break;
+        }
+    }
+    if (instrumentationEnabled()) {
+        recordCount("bellman_ford.rounds", rounds);
+        recordCount("bellman_ford.relaxations", relaxations);
+    }
+
+    // Find the farthest node from the source
+    int farthestNodeID = -1;
+    double maxDistance = 0.0;
+    for (int i = 0; i < size; i++) {
+        double distance = workspace.distance(i);
+        if (distance > maxDistance && distance != numeric_limits<double>::infinity()) {
+            maxDistance = distance;
+            farthestNodeID = graph.nodes[i].id;
+        }
+    }
+
+    return {farthestNodeID, maxDistance};
+}
+
+namespace {
+// Non-negative doubles order the same way as their bit patterns read as unsigned integers,
+// so an atomic minimum over the patterns is a minimum over the distances
+uint64_t distanceBits(double distance) {
+    uint64_t bits;
+    memcpy(&bits, &distance, sizeof(bits));
+    return bits;
+}
+
+double bitsDistance(uint64_t bits) {
+    double distance;
+    memcpy(&distance, &bits, sizeof(distance));
+    return distance;
+}
+
+// Lowers target to value if value is smaller; returns whether it did
+bool atomicMin(atomic<uint64_t>& target, uint64_t value) {
+    uint64_t current = target.load(memory_order_relaxed);
+    while (value < current) {
+        if (target.compare_exchange_weak(current, value, memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Frontiers smaller than this are relaxed on the calling thread; starting workers costs more
+const int PARALLEL_FRONTIER = 2048;
+}
+
+pair<int, double> bellman_ford_parallel(int ID, const StationGraph& graph, double threshold, BellmanFordStats* stats) {
+    ScopedTimer timer("search.bellman_ford_parallel");
+    int size = graph.size();
+    BellmanFordStats local;
+    BellmanFordStats& counters = stats != nullptr ? *stats : local;
+    counters = BellmanFordStats();
+
+    vector<atomic<uint64_t>> distance(size);
+    for (auto& d : distance) {
+        d.store(distanceBits(numeric_limits<double>::infinity()), memory_order_relaxed);
+    }
+    // round in which a node was last queued, so each enters the next frontier once
+    vector<atomic<int>> queuedRound(size);
+    for (auto& q : queuedRound) {
+        q.store(-1, memory_order_relaxed);
+    }
+    int source = graph.localIndex(ID);
+    distance[source].store(distanceBits(0.0), memory_order_relaxed);
+
+    vector<int> frontier = {source};
+    vector<vector<int>> parts;
+    mutex partsMutex;
+    atomic<long long> relaxations(0);
+    atomic<long long> improvements(0);
+    while (!frontier.empty()) {
+        int round = counters.rounds++;
+        auto relax = [&](int begin, int end) {
+            vector<int> next;
+            long long looked = 0;
+            long long lowered = 0;
+            for (int i = begin; i < end; i++) {
+                int u = frontier[i];
+                double du = bitsDistance(distance[u].load(memory_order_relaxed));
+                int edgeEnd = graph.prefixEnd(u, threshold);
+                for (int e = graph.offsets[u]; e < edgeEnd; e++) {
+                    int v = graph.targets[e];
+                    looked++;
+                    if (atomicMin(distance[v], distanceBits(du + graph.weights[e]))) {
+                        lowered++;
+                        if (queuedRound[v].exchange(round, memory_order_relaxed) != round) {
+                            next.push_back(v);
+                        }
+                    }
+                }
+            }
+            relaxations += looked;
+            improvements += lowered;
+            lock_guard<mutex> lock(partsMutex);
+            parts.push_back(move(next));
+        };
+        if (static_cast<int>(frontier.size()) < PARALLEL_FRONTIER) {
+            relax(0, static_cast<int>(frontier.size()));
+        } else {
+            counters.threads = max(counters.threads, min(workerCount(), static_cast<int>(frontier.size())));
+            parallelFor(0, static_cast<int>(frontier.size()), relax);
+        }
+        frontier.clear();
+        for (auto& part : parts) {
+            frontier.insert(frontier.end(), part.begin(), part.end());
+        }
+        parts.clear();
+    }
+    counters.relaxations = relaxations;
+    counters.improvements = improvements;
+    if (instrumentationEnabled()) {
+        recordCount("bellman_ford_parallel.rounds", counters.rounds);
+        recordCount("bellman_ford_parallel.relaxations", counters.relaxations);
+        recordCount("bellman_ford_parallel.improvements", counters.improvements);
+    }
+
+    // Find the farthest node from the source
+    int farthestNodeID = -1;
+    double maxDistance = 0.0;
+    for (int i = 0; i < size; i++) {
+        double d = bitsDistance(distance[i].load(memory_order_relaxed));
+        if (d > maxDistance && d != numeric_limits<double>::infinity()) {
+            maxDistance = d;
+            farthestNodeID = graph.nodes[i].id;
+        }
+    }
+
+    return {farthestNodeID, maxDistance};
+}
+
+pair<int, double> dijkstra_radix(int Id, const StationGraph& graph, double threshold) {
+    return dijkstra_radix(Id, graph, threshold, localWorkspace());
+}
+
+pair<int, double> dijkstra_radix(int Id, const StationGraph& graph, double threshold, SearchWorkspace& workspace) {
+    ScopedTimer timer("search.dijkstra_radix");
+    // meters are stored as doubles, which hold whole numbers exactly far beyond any route length
+    workspace.begin(graph.size());
+    int source = graph.localIndex(Id);
+    workspace.setDistance(source, 0.0);
+    RadixHeap<int>& heap = workspace.radix;
+    heap.push(0, source);
+    int farthest = -1;
+    uint64_t maxDistance = 0;
+    long long pushes = 1;
+    long long stalePops = 0;
+    long long relaxations = 0;
+    while (!heap.empty()) {
+        pair<uint64_t, int> top = heap.pop();
+        uint64_t currDist = top.first;
+        int currNode = top.second;
+        if (static_cast<double>(currDist) > workspace.distance(currNode)) {
+            stalePops++;
+            continue;
+        }
+        if (currDist > maxDistance || (currDist == maxDistance && farthest != -1 && currNode < farthest)) {
+            maxDistance = currDist;
+            farthest = currNode;
+        }
+        int end = graph.prefixEnd(currNode, threshold);
+        relaxations += end - graph.offsets[currNode];
+        for (int e = graph.offsets[currNode]; e < end; ++e) {
+            int neighbor = graph.targets[e];
+            uint64_t newDist = currDist + static_cast<uint64_t>(llround(graph.weights[e] * 1000.0));
+            if (static_cast<double>(newDist) < workspace.distance(neighbor)) {
+                workspace.setDistance(neighbor, static_cast<double>(newDist));
+                heap.push(newDist, neighbor);
+                pushes++;
+            }
+        }
+    }
+    if (instrumentationEnabled()) {
+        recordCount("dijkstra_radix.heap_pushes", pushes);
+        recordCount("dijkstra_radix.stale_pops", stalePops);
+        recordCount("dijkstra_radix.relaxations", relaxations);
+    }
+    int farthestNodeId = farthest == -1 ? -1 : graph.nodes[farthest].id;
+
+    return {farthestNodeId, maxDistance / 1000.0};
+}
+
+vector<int> dijkstra_distances(int source, const StationGraph& graph, double threshold,
+                               vector<double>& dist, vector<int>* parent) {
+    vector<int> settled;
+    dist[source] = 0.0;
+    if (parent != nullptr) {
+        (*parent)[source] = -1;
+    }
+    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<>> pq;
+    pq.push({0.0, source});
+    while (!pq.empty()) {
+        pair<double, int> top = pq.top();
+        pq.pop();
+        int u = top.second;
+        if (top.first > dist[u]) {
+            continue;
+        }
+        settled.push_back(u);
+        int end = graph.prefixEnd(u, threshold);
+        for (int e = graph.offsets[u]; e < end; ++e) {
+            int v = graph.targets[e];
+            double newDist = top.first + graph.weights[e];
+            if (newDist < dist[v]) {
+                dist[v] = newDist;
+                if (parent != nullptr) {
+                    (*parent)[v] = u;
+                }
+                pq.push({newDist, v});
+            }
+        }
+    }
+    return settled;
+}
+
+vector<int> dijkstra_decrease(int v, const StationGraph& graph, double threshold,
+                              vector<double>& dist, vector<int>* parent) {
+    vector<int> lowered;
+    double best = dist[v];
+    int via = -1;
+    int end = graph.prefixEnd(v, threshold);
+    for (int e = graph.offsets[v]; e < end; ++e) {
+        double throughNeighbor = dist[graph.targets[e]] + graph.weights[e];
+        if (throughNeighbor < best) {
+            best = throughNeighbor;
+            via = graph.targets[e];
+        }
+    }
+    if (via == -1) {
+        return lowered;
+    }
+    dist[v] = best;
+    if (parent != nullptr) {
+        (*parent)[v] = via;
+    }
+    priority_queue<pair<double, int>, vector<pair<double, int>>, greater<>> pq;
+    pq.push({best, v});
+    while (!pq.empty()) {
+        pair<double, int> top = pq.top();
+        pq.pop();
+        int u = top.second;
+        if (top.first > dist[u]) {
+            continue;
+        }
+        lowered.push_back(u);
+        end = graph.prefixEnd(u, threshold);
+        for (int e = graph.offsets[u]; e < end; ++e) {
+            int w = graph.targets[e];
+            double newDist = top.first + graph.weights[e];
+            if (newDist < dist[w]) {
+                dist[w] = newDist;
+                if (parent != nullptr) {
+                    (*parent)[w] = u;
+                }
+                pq.push({newDist, w});
+            }
+        }
+    }
+    return lowered;
+}
+
+RangeSearch::RangeSearch(const StationGraph& graph) : graph(graph) {
+}
+
+const vector<pair<int, double>>& RangeSearch::within(int Id, double radius, double threshold) {
+    ScopedTimer timer("search.range");
+    workspace.begin(graph.size());
+    result.clear();
+    int source = graph.localIndex(Id);
+    if (source == -1) {
+        return result;
+    }
+
+    workspace.setDistance(source, 0.0);
+    workspace.push(0.0, source);
+    while (!workspace.heapEmpty()) {
+        pair<double, int> top = workspace.pop();
+        int u = top.second;
+        if (top.first > workspace.distance(u)) {
+            continue;
+        }
+        result.push_back({graph.nodes[u].id, top.first});
+        int end = graph.prefixEnd(u, threshold);
+        for (int e = graph.offsets[u]; e < end; ++e) {
+            int v = graph.targets[e];
+            double newDist = top.first + graph.weights[e];
+            // anything past the radius can never be settled, so it is not queued at all
+            if (newDist <= radius && newDist < workspace.distance(v)) {
+                workspace.setDistance(v, newDist);
+                workspace.push(newDist, v);
+            }
+        }
+    }
+    return result;
+}
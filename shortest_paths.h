@@ -0,0 +1,73 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_SHORTEST_PATHS_H
+#define EV_CHARGING_STATION_OPTIMIZATION_SHORTEST_PATHS_H
+
+#include <utility>
+#include <vector>
+
+#include "graph.h"
+#include "search_workspace.h"
+
+// Single-source searches over a StationGraph. Each takes a station id and uses only edges of
+// length <= threshold, and returns {farthest reachable station id, its distance in km},
+// or {-1, 0} if nothing is reachable. The overloads without a workspace use the calling thread's.
+
+std::pair<int, double> dijkstra_alg(int Id, const StationGraph& graph, double threshold);
+std::pair<int, double> dijkstra_alg(int Id, const StationGraph& graph, double threshold, SearchWorkspace& workspace);
+
+std::pair<int, double> bellman_ford(int ID, const StationGraph& graph, double threshold);
+std::pair<int, double> bellman_ford(int ID, const StationGraph& graph, double threshold, SearchWorkspace& workspace);
+
+// Work done by bellman_ford_parallel
+struct BellmanFordStats {
+    int rounds = 0;
+    long long relaxations = 0;   // edges looked at
+    long long improvements = 0;  // relaxations that lowered a distance
+    int threads = 1;
+};
+
+// Bellman-Ford over a frontier: each round relaxes only the out-edges of nodes whose distance
+// dropped in the previous round, split across worker threads. Distances are lowered with an
+// atomic minimum on their 64-bit patterns, and each thread queues the nodes it lowered for the
+// next round. Returns the same result as bellman_ford.
+std::pair<int, double> bellman_ford_parallel(int ID, const StationGraph& graph, double threshold,
+                                             BellmanFordStats* stats = nullptr);
+
+// Dijkstra with distances quantized to whole meters and a radix heap instead of a binary heap.
+// Each edge is rounded by at most half a meter, so the reported distance is within
+// (hops / 2) meters of dijkstra_alg's.
+std::pair<int, double> dijkstra_radix(int Id, const StationGraph& graph, double threshold);
+std::pair<int, double> dijkstra_radix(int Id, const StationGraph& graph, double threshold, SearchWorkspace& workspace);
+
+// Dijkstra from a local index that leaves the full distance array behind. dist must be sized
+// to the graph and hold infinity for every node the search can reach; parent, if given, receives
+// each reached node's predecessor (-1 for the source). Returns the nodes reached, in settle order.
+std::vector<int> dijkstra_distances(int source, const StationGraph& graph, double threshold,
+                                    std::vector<double>& dist, std::vector<int>* parent = nullptr);
+
+// Decrease-only update of a distance array after node v and its edges were inserted into the graph
+// (Ramalingam-Reps for insertions). dist must hold exact distances for the graph without v, and
+// infinity for v itself. Only paths through v can have got shorter, so the search starts at v and
+// stops wherever a distance does not drop. Returns the nodes whose distance decreased.
+std::vector<int> dijkstra_decrease(int v, const StationGraph& graph, double threshold,
+                                   std::vector<double>& dist, std::vector<int>* parent = nullptr);
+
+// Stations within a route distance of a source. The search stops as soon as the nearest unsettled
+// node is beyond the radius, so it only touches the ball around the source, and its workspace
+// starts each query without clearing anything. It may be kept across rebuilds of the graph it
+// refers to.
+class RangeSearch {
+public:
+    explicit RangeSearch(const StationGraph& graph);
+
+    // (station id, km) for every station within radius of station Id, nearest first, source included
+    const std::vector<std::pair<int, double>>& within(int Id, double radius, double threshold);
+    // Nodes the last query reached
+    int touchedCount() const { return workspace.touched(); }
+
+private:
+    const StationGraph& graph;
+    SearchWorkspace workspace;
+    std::vector<std::pair<int, double>> result;
+};
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_SHORTEST_PATHS_H
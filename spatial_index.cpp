@@ -0,0 +1,261 @@
+#include "spatial_index.h"
+
+#include <cmath>
+#include <algorithm>
+#include <queue>
+#include <limits>
+
+using namespace std;
+
+namespace {
+const double KM_PER_LAT_DEGREE = earthR * M_PI / 180.0;
+}
+
+SpatialGrid::SpatialGrid(const vector<Node>& nodes, double cellKm) : nodes(nodes), cellKm(cellKm) {
+    int n = nodes.size();
+    maxAbsLat = 0.0;
+    for (const Node& node : nodes) {
+        maxAbsLat = max(maxAbsLat, fabs(node.latitude));
+    }
+    kmPerLonDegree = KM_PER_LAT_DEGREE * cos(min(maxAbsLat, 89.0) * M_PI / 180.0);
+
+    minX = minY = numeric_limits<double>::infinity();
+    double maxX = -numeric_limits<double>::infinity();
+    double maxY = -numeric_limits<double>::infinity();
+    for (const Node& node : nodes) {
+        double x = projectX(node.longitude);
+        double y = node.latitude * KM_PER_LAT_DEGREE;
+        minX = min(minX, x);
+        minY = min(minY, y);
+        maxX = max(maxX, x);
+        maxY = max(maxY, y);
+    }
+    if (n == 0) {
+        minX = minY = maxX = maxY = 0.0;
+    }
+
+    // Default cell size aims for about two stations per cell
+    double area = max(maxX - minX, 1.0) * max(maxY - minY, 1.0);
+    if (this->cellKm <= 0.0) {
+        this->cellKm = sqrt(area / max(n / 2, 1));
+    }
+    this->cellKm = max(this->cellKm, 0.01);
+    width = static_cast<int>((maxX - minX) / this->cellKm) + 1;
+    height = static_cast<int>((maxY - minY) / this->cellKm) + 1;
+
+    // Counting sort of stations by cell
+    vector<int> cellOf(n);
+    cellStart.assign(static_cast<size_t>(width) * height + 1, 0);
+    for (int i = 0; i < n; i++) {
+        int cx = cellX(projectX(nodes[i].longitude));
+        int cy = cellY(nodes[i].latitude * KM_PER_LAT_DEGREE);
+        cellOf[i] = cy * width + cx;
+        cellStart[cellOf[i] + 1]++;
+    }
+    for (size_t c = 1; c < cellStart.size(); c++) {
+        cellStart[c] += cellStart[c - 1];
+    }
+    order.resize(n);
+    vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (int i = 0; i < n; i++) {
+        order[fill[cellOf[i]]++] = i;
+    }
+}
+
+// Clamped before the cast, since converting a double out of int's range (or nan) is undefined
+int SpatialGrid::cellX(double x) const {
+    double cx = floor((x - minX) / cellKm);
+    return cx >= 0.0 ? static_cast<int>(min(cx, width - 1.0)) : 0;
+}
+
+int SpatialGrid::cellY(double y) const {
+    double cy = floor((y - minY) / cellKm);
+    return cy >= 0.0 ? static_cast<int>(min(cy, height - 1.0)) : 0;
+}
+
+bool SpatialGrid::covers(double latitude, double longitude) const {
+    double x = (projectX(longitude) - minX) / cellKm;
+    double y = (latitude * KM_PER_LAT_DEGREE - minY) / cellKm;
+    // the longitude scale only keeps projected distances short enough up to maxAbsLat
+    return fabs(latitude) <= maxAbsLat && x >= 0.0 && x < width && y >= 0.0 && y < height;
+}
+
+template <typename Visit>
+void SpatialGrid::forEachInCell(int cx, int cy, Visit visit) const {
+    int c = cy * width + cx;
+    for (int p = cellStart[c]; p < cellStart[c + 1]; p++) {
+        visit(order[p]);
+    }
+    auto extra = added.find(c);
+    if (extra != added.end()) {
+        for (int i : extra->second) {
+            visit(i);
+        }
+    }
+}
+
+bool SpatialGrid::add(int index) {
+    const Node& node = nodes[index];
+    if (!covers(node.latitude, node.longitude)) {
+        return false;
+    }
+    int c = cellY(node.latitude * KM_PER_LAT_DEGREE) * width + cellX(projectX(node.longitude));
+    added[c].push_back(index);
+    return true;
+}
+
+vector<pair<double, int>> SpatialGrid::within(double latitude, double longitude, double radius, int exclude) const {
+    vector<pair<double, int>> found;
+    auto check = [&](int i) {
+        if (i == exclude) {
+            return;
+        }
+        double d = haversine(latitude, longitude, nodes[i].latitude, nodes[i].longitude);
+        if (d <= radius) {
+            found.push_back({d, i});
+        }
+    };
+    if (!covers(latitude, longitude)) {
+        for (int i = 0; i < static_cast<int>(nodes.size()); i++) {
+            check(i);
+        }
+        return found;
+    }
+    int qx = cellX(projectX(longitude));
+    int qy = cellY(latitude * KM_PER_LAT_DEGREE);
+    // projected distances never exceed the real ones, so nothing within radius is further off
+    int rings = static_cast<int>(min(ceil(radius / cellKm), static_cast<double>(max(width, height))));
+    for (int cy = max(qy - rings, 0); cy <= min(qy + rings, height - 1); cy++) {
+        for (int cx = max(qx - rings, 0); cx <= min(qx + rings, width - 1); cx++) {
+            forEachInCell(cx, cy, check);
+        }
+    }
+    return found;
+}
+
+vector<pair<double, int>> SpatialGrid::nearest(double latitude, double longitude, int k, int exclude) const {
+    // max-heap of the best k found so far
+    priority_queue<pair<double, int>> best;
+    if (k <= 0 || nodes.empty()) {
+        return {};
+    }
+    int qx = cellX(projectX(longitude));
+    int qy = cellY(latitude * KM_PER_LAT_DEGREE);
+    int maxRing = max(max(qx, width - 1 - qx), max(qy, height - 1 - qy));
+
+    auto scanCell = [&](int cx, int cy) {
+        forEachInCell(cx, cy, [&](int i) {
+            if (i == exclude) {
+                return;
+            }
+            double d = haversine(latitude, longitude, nodes[i].latitude, nodes[i].longitude);
+            if (static_cast<int>(best.size()) < k) {
+                best.push({d, i});
+            } else if (d < best.top().first) {
+                best.pop();
+                best.push({d, i});
+            }
+        });
+    };
+
+    for (int ring = 0; ring <= maxRing; ring++) {
+        // walk the square of cells at Chebyshev distance ring from the query cell
+        for (int cx = qx - ring; cx <= qx + ring; cx++) {
+            if (cx < 0 || cx >= width) {
+                continue;
+            }
+            if (qy - ring >= 0) {
+                scanCell(cx, qy - ring);
+            }
+            if (ring > 0 && qy + ring < height) {
+                scanCell(cx, qy + ring);
+            }
+        }
+        for (int cy = qy - ring + 1; cy <= qy + ring - 1; cy++) {
+            if (cy < 0 || cy >= height) {
+                continue;
+            }
+            if (qx - ring >= 0) {
+                scanCell(qx - ring, cy);
+            }
+            if (qx + ring < width) {
+                scanCell(qx + ring, cy);
+            }
+        }
+        // anything in a further ring is at least ring cells away
+        if (static_cast<int>(best.size()) == k && best.top().first <= ring * cellKm) {
+            break;
+        }
+    }
+
+    vector<pair<double, int>> result;
+    result.reserve(best.size());
+    while (!best.empty()) {
+        result.push_back(best.top());
+        best.pop();
+    }
+    reverse(result.begin(), result.end());
+    return result;
+}
+
+unsigned long long hilbertIndex(double latitude, double longitude, double minLat, double minLon,
+                                double maxLat, double maxLon, int order) {
+    unsigned long long side = 1ULL << order;
+    auto scale = [side](double value, double low, double high) {
+        if (high <= low) {
+            return 0ULL;
+        }
+        double t = (value - low) / (high - low);
+        unsigned long long cell = static_cast<unsigned long long>(t * side);
+        return cell >= side ? side - 1 : cell;
+    };
+    unsigned long long x = scale(longitude, minLon, maxLon);
+    unsigned long long y = scale(latitude, minLat, maxLat);
+
+    // Standard xy -> d conversion, rotating the quadrant at each level
+    unsigned long long d = 0;
+    for (unsigned long long s = side / 2; s > 0; s /= 2) {
+        unsigned long long rx = (x & s) > 0 ? 1 : 0;
+        unsigned long long ry = (y & s) > 0 ? 1 : 0;
+        d += s * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            swap(x, y);
+        }
+    }
+    return d;
+}
+
+void sortByHilbertCurve(vector<Node>& nodes) {
+    if (nodes.size() < 2) {
+        return;
+    }
+    double minLat = numeric_limits<double>::infinity(), minLon = numeric_limits<double>::infinity();
+    double maxLat = -numeric_limits<double>::infinity(), maxLon = -numeric_limits<double>::infinity();
+    for (const Node& node : nodes) {
+        minLat = min(minLat, node.latitude);
+        maxLat = max(maxLat, node.latitude);
+        minLon = min(minLon, node.longitude);
+        maxLon = max(maxLon, node.longitude);
+    }
+
+    vector<pair<unsigned long long, int>> keys(nodes.size());
+    for (size_t i = 0; i < nodes.size(); i++) {
+        keys[i] = {hilbertIndex(nodes[i].latitude, nodes[i].longitude, minLat, minLon, maxLat, maxLon), nodes[i].id};
+    }
+    vector<int> order(nodes.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    sort(order.begin(), order.end(), [&keys](int a, int b) { return keys[a] < keys[b]; });
+
+    vector<Node> sorted;
+    sorted.reserve(nodes.size());
+    for (int i : order) {
+        sorted.push_back(nodes[i]);
+    }
+    nodes.swap(sorted);
+}
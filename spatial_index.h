@@ -0,0 +1,57 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_SPATIAL_INDEX_H
+#define EV_CHARGING_STATION_OPTIMIZATION_SPATIAL_INDEX_H
+
+#include <vector>
+#include <utility>
+#include <unordered_map>
+
+#include "graph.h"
+
+// Uniform grid over a set of stations for nearest-neighbor lookups.
+// Coordinates are projected to km with the longitude scale of the highest latitude,
+// so a projected distance never exceeds the haversine distance and can bound the search.
+class SpatialGrid {
+public:
+    SpatialGrid(const std::vector<Node>& nodes, double cellKm = 0.0);
+
+    // k nearest stations to a point as (distance km, index into nodes), nearest first.
+    // The station at index exclude (if any) is skipped.
+    std::vector<std::pair<double, int>> nearest(double latitude, double longitude, int k, int exclude = -1) const;
+    // Every station within radius km of a point as (distance km, index into nodes), in no
+    // particular order. Only the cells around the point are searched, unless it is outside the grid.
+    std::vector<std::pair<double, int>> within(double latitude, double longitude, double radius,
+                                               int exclude = -1) const;
+    // Adds nodes[index], appended to nodes after the grid was made. Returns false, adding nothing,
+    // if it lies outside the grid, where the cells could not bound its distances; make a new grid.
+    bool add(int index);
+
+    double cellSize() const { return cellKm; }
+
+private:
+    const std::vector<Node>& nodes;
+    double cellKm;
+    double maxAbsLat;
+    double kmPerLonDegree;
+    double minX, minY;
+    int width, height;
+    std::vector<int> cellStart;  // stations of cell c are order[cellStart[c] .. cellStart[c + 1])
+    std::vector<int> order;
+    std::unordered_map<int, std::vector<int>> added;  // stations added to each cell since then
+
+    double projectX(double longitude) const { return longitude * kmPerLonDegree; }
+    int cellX(double x) const;
+    int cellY(double y) const;
+    bool covers(double latitude, double longitude) const;
+    template <typename Visit>
+    void forEachInCell(int cx, int cy, Visit visit) const;
+};
+
+// Position of a point along a Hilbert curve of the given order over the bounding box
+unsigned long long hilbertIndex(double latitude, double longitude, double minLat, double minLon,
+                                double maxLat, double maxLon, int order = 16);
+
+// Sorts stations along a Hilbert curve over their bounding box, so stations that are close
+// on the map are close in the vector. Station ids are left unchanged.
+void sortByHilbertCurve(std::vector<Node>& nodes);
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_SPATIAL_INDEX_H
@@ -0,0 +1,111 @@
+#include "synthetic.h"
+
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+const double KM_PER_DEGREE = earthR * M_PI / 180.0;
+}
+
+StationGenerator::StationGenerator(const SyntheticOptions& options) : options(options), random(options.seed) {
+    double sideKm = sqrt(options.count / options.stationsPerKm2);
+    halfLat = sideKm / KM_PER_DEGREE / 2.0;
+    halfLon = halfLat / cos(options.centerLat * M_PI / 180.0);
+    if (options.layout == StationLayout::Clustered) {
+        // A few big cities and many small towns, roughly like real station counts per metro
+        double total = 0.0;
+        for (int c = 0; c < max(1, options.clusters); c++) {
+            double latitude, longitude;
+            uniformPoint(latitude, longitude);
+            centerLats.push_back(latitude);
+            centerLons.push_back(longitude);
+            total += 1.0 / (c + 1);
+            cumulativeWeight.push_back(total);
+        }
+    }
+}
+
+// mt19937's output is fixed by the standard but the library distributions are not, so values
+// are derived from its raw 32-bit output to stay the same on every compiler
+double StationGenerator::unit() {
+    return random() / 4294967296.0;
+}
+
+// Box-Muller, using one of the pair
+double StationGenerator::gaussian() {
+    double u1 = (random() + 1.0) / 4294967297.0;
+    double u2 = unit();
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+void StationGenerator::uniformPoint(double& latitude, double& longitude) {
+    latitude = options.centerLat - halfLat + 2.0 * halfLat * unit();
+    longitude = options.centerLon - halfLon + 2.0 * halfLon * unit();
+}
+
+Node StationGenerator::next() {
+    Node node;
+    node.id = static_cast<int>(nextId++);
+    node.stateOrProvince = options.state;
+    if (options.layout == StationLayout::Uniform || unit() < options.ruralFraction) {
+        uniformPoint(node.latitude, node.longitude);
+        return node;
+    }
+    double pick = unit() * cumulativeWeight.back();
+    int c = static_cast<int>(upper_bound(cumulativeWeight.begin(), cumulativeWeight.end(), pick) -
+                             cumulativeWeight.begin());
+    c = min(c, static_cast<int>(cumulativeWeight.size()) - 1);
+    double radiusLat = options.clusterRadiusKm / KM_PER_DEGREE;
+    node.latitude = centerLats[c] + gaussian() * radiusLat;
+    node.longitude = centerLons[c] + gaussian() * radiusLat / cos(options.centerLat * M_PI / 180.0);
+    return node;
+}
+
+vector<Node> generateStations(const SyntheticOptions& options) {
+    vector<Node> nodes;
+    nodes.reserve(options.count);
+    StationGenerator generator(options);
+    while (!generator.done()) {
+        nodes.push_back(generator.next());
+    }
+    return nodes;
+}
+
+vector<Node> uniformStations(int count, double stationsPerKm2, unsigned seed, const string& state,
+                             double centerLat, double centerLon) {
+    SyntheticOptions options;
+    options.count = count;
+    options.stationsPerKm2 = stationsPerKm2;
+    options.seed = seed;
+    options.state = state;
+    options.centerLat = centerLat;
+    options.centerLon = centerLon;
+    return generateStations(options);
+}
+
+long long writeStationsCSV(const SyntheticOptions& options, ostream& out) {
+    out << "ID,Title,AddressLine1,Town,Postcode,Country,StateOrProvince,Operator,UsageType,Latitude,Longitude\n";
+    StationGenerator generator(options);
+    // rows are formatted into a fixed buffer; at tens of millions of rows stream formatting dominates
+    char row[512];
+    long long rows = 0;
+    while (!generator.done()) {
+        Node node = generator.next();
+        long long id = node.id;
+        // Every fourth address spans two lines and every seventh operator has quotes and a comma
+        // inside its quoted field, the cases the loader has to stitch back together
+        const char* addressFormat = id % 4 == 0 ? "\"%lld Main St\nSuite %lld\"" : "%lld Main St Suite %lld";
+        char address[96];
+        snprintf(address, sizeof(address), addressFormat, id % 9000 + 100, id % 97);
+        const char* operatorName = id % 7 == 0 ? "\"\"\"Volt\"\" Charging, Inc.\"" : "Open Charge Network";
+        int length = snprintf(row, sizeof(row), "%lld,Synthetic Station %lld,%s,Town %lld,%05lld,US,%s,%s,Public,%.6f,%.6f\n",
+                              id, id, address, id % 1000, id % 100000, node.stateOrProvince.c_str(), operatorName,
+                              node.latitude, node.longitude);
+        out.write(row, min(length, static_cast<int>(sizeof(row)) - 1));
+        rows++;
+    }
+    return rows;
+}
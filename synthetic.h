@@ -0,0 +1,67 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_SYNTHETIC_H
+#define EV_CHARGING_STATION_OPTIMIZATION_SYNTHETIC_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <random>
+
+#include "graph.h"
+
+enum class StationLayout {
+    Uniform,   // spread evenly over the whole square
+    Clustered  // mostly around a few city centers of very different sizes, the rest spread evenly
+};
+
+struct SyntheticOptions {
+    long long count = 1000;
+    StationLayout layout = StationLayout::Uniform;
+    // Average density over the square the stations are placed in, which sets its size
+    double stationsPerKm2 = 0.5;
+    int clusters = 20;
+    double clusterRadiusKm = 4.0;  // standard deviation of the distance from a city center
+    double ruralFraction = 0.1;    // share of clustered stations placed uniformly instead
+    unsigned seed = 1;
+    std::string state = "CA";
+    double centerLat = 37.0;
+    double centerLon = -95.0;
+};
+
+// Produces the stations described by options one at a time, so any number of them can be
+// written out without holding them in memory. Ids run from 0 to count - 1, and the same
+// options always produce the same stations on every platform.
+class StationGenerator {
+public:
+    explicit StationGenerator(const SyntheticOptions& options);
+
+    bool done() const { return nextId >= options.count; }
+    Node next();
+
+private:
+    SyntheticOptions options;
+    std::mt19937 random;
+    long long nextId = 0;
+    double halfLat;
+    double halfLon;
+    std::vector<double> centerLats;
+    std::vector<double> centerLons;
+    std::vector<double> cumulativeWeight;  // cluster c is picked with weight 1 / (c + 1)
+
+    double unit();
+    double gaussian();
+    void uniformPoint(double& latitude, double& longitude);
+};
+
+std::vector<Node> generateStations(const SyntheticOptions& options);
+
+// count stations spread uniformly over a square centered on (centerLat, centerLon), sized so
+// there are stationsPerKm2 stations per square km on average
+std::vector<Node> uniformStations(int count, double stationsPerKm2, unsigned seed, const std::string& state,
+                                  double centerLat = 37.0, double centerLon = -95.0);
+
+// Writes the stations in the Open Charge Map column layout loadStations reads: state in
+// column 6, latitude and longitude in columns 9 and 10, with some rows carrying quoted fields
+// that span lines or contain escaped quotes like the real export. Returns the rows written.
+long long writeStationsCSV(const SyntheticOptions& options, std::ostream& out);
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_SYNTHETIC_H
@@ -0,0 +1,193 @@
+#include "task_pool.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+// The pool and worker index of the calling thread, if it is a pool worker
+thread_local TaskPool* currentPool = nullptr;
+thread_local int currentWorker = -1;
+}
+
+TaskPool::TaskPool(int workers) : pending(0), queued(0) {
+    workers = max(0, workers);
+    for (int i = 0; i < workers; i++) {
+        queues.emplace_back(new WorkerQueue());
+    }
+    for (int i = 0; i < workers; i++) {
+        threads.emplace_back(&TaskPool::work, this, i);
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        lock_guard<mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void TaskPool::submit(function<void()> task) {
+    bool helping;
+    {
+        // a task on a worker's deque is counted before the deque is unlocked, so no thief can run
+        // and finish it first and let pending reach 0 with work still to do
+        unique_lock<mutex> queueLock;
+        if (currentPool == this) {
+            WorkerQueue& own = *queues[currentWorker];
+            queueLock = unique_lock<mutex>(own.mutex);
+            own.tasks.push_back(move(task));
+        }
+        lock_guard<mutex> lock(stateMutex);
+        if (currentPool != this) {
+            shared.push_back(move(task));
+        }
+        pending++;
+        queued++;
+        helping = helpers > 0;
+    }
+    wake.notify_one();
+    if (helping) {
+        changed.notify_all();
+    }
+}
+
+void TaskPool::wait() {
+    int self = currentPool == this ? currentWorker : -1;
+    auto done = [this] { return pending == 0; };
+    while (!done()) {
+        function<void()> task;
+        if (take(self, task)) {
+            task();
+            finish();
+            continue;
+        }
+        // nothing to run: sleep until there is, or until a task finishes and done() may be true
+        unique_lock<mutex> lock(stateMutex);
+        helpers++;
+        changed.wait(lock, [&] { return queued > 0 || done(); });
+        helpers--;
+    }
+}
+
+bool TaskPool::take(int self, function<void()>& task) {
+    bool found = false;
+    if (self >= 0) {
+        WorkerQueue& own = *queues[self];
+        lock_guard<mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = move(own.tasks.back());
+            own.tasks.pop_back();
+            found = true;
+        }
+    }
+    if (!found) {
+        lock_guard<mutex> lock(stateMutex);
+        if (!shared.empty()) {
+            task = move(shared.front());
+            shared.pop_front();
+            found = true;
+        }
+    }
+    // steal the oldest task of the next worker that has one
+    int count = static_cast<int>(queues.size());
+    for (int i = 1; i <= count && !found; i++) {
+        int victimIndex = (self + i) % count;
+        if (victimIndex == self) {
+            continue;
+        }
+        WorkerQueue& victim = *queues[victimIndex];
+        lock_guard<mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            found = true;
+        }
+    }
+    if (found) {
+        lock_guard<mutex> lock(stateMutex);
+        queued--;
+    }
+    return found;
+}
+
+void TaskPool::finish() {
+    lock_guard<mutex> lock(stateMutex);
+    pending--;
+    if (helpers > 0) {
+        changed.notify_all();
+    }
+}
+
+void TaskPool::work(int self) {
+    currentPool = this;
+    currentWorker = self;
+    while (true) {
+        {
+            unique_lock<mutex> lock(stateMutex);
+            wake.wait(lock, [this] { return queued > 0 || stopping; });
+            if (queued == 0) {
+                return;
+            }
+        }
+        function<void()> task;
+        if (!take(self, task)) {
+            continue;  // another thread got there first
+        }
+        task();
+        finish();
+    }
+}
+
+TaskGroup::TaskGroup(TaskPool& pool) : pool(pool), state(make_shared<State>()) {}
+
+bool TaskGroup::State::runOne() {
+    function<void()> task;
+    {
+        lock_guard<mutex> lock(taskMutex);
+        if (tasks.empty()) {
+            return false;
+        }
+        task = move(tasks.front());
+        tasks.pop_front();
+    }
+    task();
+    lock_guard<mutex> lock(taskMutex);
+    if (--remaining == 0) {
+        changed.notify_all();
+    }
+    return true;
+}
+
+void TaskGroup::run(function<void()> task) {
+    {
+        lock_guard<mutex> lock(state->taskMutex);
+        state->tasks.push_back(move(task));
+        state->remaining++;
+    }
+    state->changed.notify_all();
+    // the pool task starts whichever of the group's tasks is oldest, or does nothing if wait() got
+    // to them first; with no workers to run it, it would only sit in the queue
+    if (pool.size() > 0) {
+        shared_ptr<State> group = state;
+        pool.submit([group] { group->runOne(); });
+    }
+}
+
+void TaskGroup::wait() {
+    State& group = *state;
+    unique_lock<mutex> lock(group.taskMutex);
+    while (group.remaining > 0) {
+        if (group.tasks.empty()) {
+            group.changed.wait(lock);  // every remaining task is running on a worker
+            continue;
+        }
+        lock.unlock();
+        group.runOne();
+        lock.lock();
+    }
+}
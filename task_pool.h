@@ -0,0 +1,90 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_TASK_POOL_H
+#define EV_CHARGING_STATION_OPTIMIZATION_TASK_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads with a deque of tasks each. Tasks submitted from outside the pool
+// go to a shared queue and start in submission order, so submitting the longest first keeps the
+// makespan short. Tasks submitted by a task go to the back of its worker's own deque, which that
+// worker takes from the back; a worker with nothing of its own takes from the shared queue and
+// then steals from the front of the other workers' deques.
+//
+// A thread in wait() runs queued tasks while it waits, so a pool with no workers runs everything
+// on the waiting thread.
+class TaskPool {
+public:
+    explicit TaskPool(int workers);
+    ~TaskPool();
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    void submit(std::function<void()> task);
+    // Runs queued tasks until every task submitted so far has finished. Not for use inside a task,
+    // which counts as unfinished; tasks wait for the work they fork with a TaskGroup.
+    void wait();
+    int size() const { return static_cast<int>(threads.size()); }
+
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::deque<std::function<void()>> shared;
+    std::vector<std::thread> threads;
+    // guards shared and stopping, and every change to pending and queued, so waiters can't miss one.
+    // Taken while holding a worker queue's mutex, never the other way round.
+    std::mutex stateMutex;
+    std::condition_variable wake;      // a task was queued, or the pool is stopping
+    std::condition_variable changed;   // a task was queued or finished, for wait
+    std::atomic<int> pending;   // submitted and not yet finished
+    std::atomic<int> queued;    // submitted and not yet started
+    int helpers = 0;            // threads blocked in wait
+    bool stopping = false;
+
+    void work(int self);
+    // Takes a task for worker self (-1 for a thread outside the pool)
+    bool take(int self, std::function<void()>& task);
+    void finish();
+};
+
+// Fork-join over a pool: tasks run() here can be waited for as a group, separately from
+// everything else in the pool. wait() runs the group's own tasks that no worker has started yet
+// and sleeps once the rest are all running, so a thread waiting on a group never picks up
+// unrelated work, such as a whole other state queued on the same pool. Groups nest, and tasks
+// may add to their own group while it is waited on.
+class TaskGroup {
+public:
+    explicit TaskGroup(TaskPool& pool);
+    ~TaskGroup() { wait(); }
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void run(std::function<void()> task);
+    void wait();
+
+private:
+    // Shared with the pool tasks that start this group's tasks, which may outlive the group
+    struct State {
+        std::mutex taskMutex;                     // guards everything below
+        std::condition_variable changed;          // a task was added or finished
+        std::deque<std::function<void()>> tasks;  // not started yet, oldest first
+        int remaining = 0;                        // not finished yet
+
+        // Runs the oldest task not yet started; false if there was none
+        bool runOne();
+    };
+
+    TaskPool& pool;
+    std::shared_ptr<State> state;
+};
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_TASK_POOL_H
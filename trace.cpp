@@ -0,0 +1,113 @@
+#include "trace.h"
+#include "json.h"
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+atomic<bool> tracingActive(false);
+
+namespace {
+struct TraceEvent {
+    const char* name;
+    char phase;          // 'B' or 'E'
+    long long ns;        // since the trace epoch
+    string detail;
+};
+
+struct ThreadEvents {
+    int tid;
+    vector<TraceEvent> events;
+};
+
+const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+
+// Only taken when a thread records its first event; appending to a buffer takes no lock
+mutex registryMutex;
+vector<unique_ptr<ThreadEvents>> registry;
+string traceFile;
+
+ThreadEvents& localEvents() {
+    thread_local ThreadEvents* events = nullptr;
+    if (events == nullptr) {
+        lock_guard<mutex> lock(registryMutex);
+        registry.emplace_back(new ThreadEvents());
+        events = registry.back().get();
+        events->tid = static_cast<int>(registry.size());
+        events->events.reserve(1024);
+    }
+    return *events;
+}
+
+long long sinceEpoch() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
+}
+
+void writeTraceAtExit() {
+    if (writeTrace(traceFile)) {
+        // stderr, so a headless run's JSON on stdout stays clean
+        cerr << "Wrote trace to " << traceFile << endl;
+    }
+}
+}
+
+void startTracing(const string& file) {
+    static bool registered = false;
+    traceFile = file;
+    if (!registered) {
+        atexit(writeTraceAtExit);
+        registered = true;
+    }
+    tracingActive.store(true, memory_order_relaxed);
+}
+
+void recordTraceBegin(const char* name, const string& detail) {
+    localEvents().events.push_back({name, 'B', sinceEpoch(), detail});
+}
+
+void recordTraceEnd(const char* name) {
+    localEvents().events.push_back({name, 'E', sinceEpoch(), string()});
+}
+
+bool writeTrace(const string& file) {
+    ofstream out(file);
+    // errors go to stderr too, like the success message, so stdout keeps only results
+    if (!out.is_open()) {
+        cerr << "Error: Could not open file " << file << endl;
+        return false;
+    }
+    lock_guard<mutex> lock(registryMutex);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    for (const auto& thread : registry) {
+        // the first thread to record is the one running the menu
+        out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+            << thread->tid << ", \"args\": {\"name\": \""
+            << (thread->tid == 1 ? string("main") : "worker " + to_string(thread->tid - 1)) << "\"}}";
+        first = false;
+        for (const TraceEvent& event : thread->events) {
+            char ts[32];
+            snprintf(ts, sizeof(ts), "%.3f", event.ns / 1000.0);
+            out << ",\n{\"name\": \"" << event.name << "\", \"ph\": \"" << event.phase << "\", \"ts\": " << ts
+                << ", \"pid\": 1, \"tid\": " << thread->tid;
+            if (!event.detail.empty()) {
+                out << ", \"args\": {\"detail\": " << jsonQuote(event.detail) << "}";
+            }
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+    out.close();
+    if (!out) {
+        cerr << "Error: Could not write " << file << endl;
+        return false;
+    }
+    return true;
+}
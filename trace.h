@@ -0,0 +1,47 @@
+#ifndef EV_CHARGING_STATION_OPTIMIZATION_TRACE_H
+#define EV_CHARGING_STATION_OPTIMIZATION_TRACE_H
+
+#include <atomic>
+#include <string>
+
+// Begin/end events in Chrome's trace-event format, for viewing a whole session on a timeline
+// (chrome://tracing or ui.perfetto.dev). Each thread appends to its own buffer without locking;
+// the buffers are kept after their threads exit and written out together when the program ends.
+// Phases timed with ScopedTimer are traced too.
+
+extern std::atomic<bool> tracingActive;
+
+inline bool tracingEnabled() { return tracingActive.load(std::memory_order_relaxed); }
+
+// Starts recording; the trace is written to file when the program exits
+void startTracing(const std::string& file);
+
+// detail is shown as the event's argument, e.g. the state being loaded
+void recordTraceBegin(const char* name, const std::string& detail);
+void recordTraceEnd(const char* name);
+
+// Writes every event recorded so far. Threads still recording must not be running.
+bool writeTrace(const std::string& file);
+
+// Traces from construction to destruction, if tracing was on at construction
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, const std::string& detail = std::string())
+            : name(tracingEnabled() ? name : nullptr) {
+        if (this->name != nullptr) {
+            recordTraceBegin(name, detail);
+        }
+    }
+    ~TraceScope() {
+        if (name != nullptr) {
+            recordTraceEnd(name);
+        }
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+};
+
+#endif //EV_CHARGING_STATION_OPTIMIZATION_TRACE_H